@@ -0,0 +1,102 @@
+#include "valset.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Times `ValueSet` operations with each kernel set supported by the CPU
+
+namespace {
+volatile unsigned g_sink = 0;
+const std::size_t kPoolSize = 8;
+
+ValueSet makeRandomSet(std::mt19937& gen, unsigned bit_count, unsigned density_percent) {
+    ValueSet vset;
+    std::uniform_int_distribution<unsigned> dist(0, 99);
+    for (unsigned v = 0; v < bit_count; ++v) {
+        if (dist(gen) < density_percent) { vset.addValue(v); }
+    }
+    vset.addValue(bit_count - 1);  // All sets of the same bit count have the same size
+    return vset;
+}
+
+template<typename Func>
+double measure(std::size_t iter_count, Func func) {
+    // The first pass warms up caches and branch predictors, the best of the others is taken
+    const unsigned repeat_count = 5;
+    double best_time = 0;
+    for (unsigned n_repeat = 0; n_repeat <= repeat_count; ++n_repeat) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t n = 0; n < iter_count; ++n) { func(n); }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        const double time = elapsed.count() / static_cast<double>(iter_count);
+        if (n_repeat == 1 || (n_repeat > 1 && time < best_time)) { best_time = time; }
+    }
+    return best_time;
+}
+
+void printTime(double time) {
+    if (time > 0) {
+        std::printf(" %8.1fns", time);
+    } else {
+        std::printf(" %10s", "n/a");  // Below timer resolution
+    }
+}
+}  // namespace
+
+int main() {
+    const std::pair<ValueSet::KernelSet, const char*> kernel_sets[] = {
+        {ValueSet::KernelSet::kScalar, "scalar"},
+        {ValueSet::KernelSet::kSse2, "sse2"},
+        {ValueSet::KernelSet::kAvx2, "avx2"},
+    };
+    const unsigned bit_counts[] = {256, 2048, 16384};
+    const std::size_t total_bits = std::size_t(1) << 26;
+
+    std::printf("%-8s %7s %10s %10s %10s %10s %10s %10s %10s\n", "kernels", "bits", "|=", "orChanged", "&=", "-=",
+                "==", "empty()", "iterate");
+    for (const auto& [kernel_set, kernel_name] : kernel_sets) {
+        if (!ValueSet::selectKernels(kernel_set)) {
+            std::printf("%-8s not supported\n", kernel_name);
+            continue;
+        }
+        for (unsigned bit_count : bit_counts) {
+            std::mt19937 gen(bit_count);
+            const ValueSet lhs = makeRandomSet(gen, bit_count, 10), rhs = makeRandomSet(gen, bit_count, 10);
+            const ValueSet zero = ValueSet(bit_count - 1, bit_count - 1).removeValue(bit_count - 1);
+            const std::size_t iter_count = total_bits / bit_count;
+
+            // Operations work on a pool of operand copies instead of restoring the operand every iteration,
+            // so that nothing but the operation is timed; kernels take the same time for any set contents
+            std::vector<ValueSet> pool(kPoolSize, lhs);
+            auto measure_op = [&](auto op) {
+                std::fill(pool.begin(), pool.end(), lhs);
+                return measure(iter_count, [&](std::size_t n) {
+                    ValueSet& vset = pool[n % kPoolSize];
+                    op(vset);
+                    g_sink = g_sink + vset.contains(0);
+                });
+            };
+            const double or_time = measure_op([&](ValueSet& vset) { vset |= rhs; });
+            const double or_changed_time = measure_op([&](ValueSet& vset) { g_sink = g_sink + vset.orChanged(rhs); });
+            const double and_time = measure_op([&](ValueSet& vset) { vset &= rhs; });
+            const double sub_time = measure_op([&](ValueSet& vset) { vset -= rhs; });
+            const ValueSet lhs_copy = lhs;  // Equal sets are compared completely
+            const double eq_time = measure(iter_count, [&](std::size_t) { g_sink = g_sink + (lhs == lhs_copy); });
+            const double empty_time = measure(iter_count, [&](std::size_t) { g_sink = g_sink + zero.empty(); });
+            const double iterate_time = measure(iter_count, [&](std::size_t) {
+                unsigned sum = 0;
+                for (unsigned v : lhs) { sum += v; }
+                g_sink = g_sink + sum;
+            });
+            std::printf("%-8s %7u", kernel_name, bit_count);
+            for (double time : {or_time, or_changed_time, and_time, sub_time, eq_time, empty_time, iterate_time}) {
+                printTime(time);
+            }
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
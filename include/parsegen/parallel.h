@@ -0,0 +1,346 @@
+#pragma once
+
+// Speculative parallel parsing driver for analyzers with synchronization tokens declared by `%sync`
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parsegen {
+
+// Fixed set of worker threads, which run index loops together with the calling thread
+class thread_pool {
+ public:
+    explicit thread_pool(unsigned thread_count = std::thread::hardware_concurrency()) {
+        for (unsigned n = 1; n < std::max(thread_count, 1u); ++n) {
+            threads_.emplace_back([this] { work(); });
+        }
+    }
+    ~thread_pool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto& thread : threads_) { thread.join(); }
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    unsigned thread_count() const { return static_cast<unsigned>(threads_.size()) + 1; }
+
+    // Calls `func(i)` for each `i` in [0, count) and returns when all calls are done,
+    // only one loop can be run at a time
+    template<typename Func>
+    void for_each_index(std::size_t count, Func func) {
+        std::atomic<std::size_t> next{0};
+        auto body = [&next, count, &func] {
+            for (std::size_t i = next++; i < count; i = next++) { func(i); }
+        };
+        {
+            std::lock_guard lock(mutex_);
+            job_ = body;
+            active_count_ = threads_.size();
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        body();
+        std::unique_lock lock(mutex_);
+        done_cv_.wait(lock, [this] { return active_count_ == 0; });
+        job_ = nullptr;
+    }
+
+ private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    std::function<void()> job_;
+    std::size_t active_count_ = 0;
+    std::size_t generation_ = 0;
+    bool stop_ = false;
+
+    void work() {
+        std::size_t generation = 0;
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex_);
+                start_cv_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+                if (stop_) { return; }
+                generation = generation_;
+                job = job_;
+            }
+            job();
+            std::lock_guard lock(mutex_);
+            if (--active_count_ == 0) { done_cv_.notify_one(); }
+        }
+    }
+};
+
+struct reduction {
+    int action;            // Action code returned by `parse()`
+    int length;            // Reduction length
+    std::size_t tt_index;  // Index of the look-ahead token
+};
+
+// The input is split into segments starting with synchronization tokens. Each segment is parsed in parallel from all
+// states, in which its first token can be shifted, until a reduction pops this entry state. Then segments are joined
+// sequentially: the result for the actual state is taken and the remaining reductions at the end of the segment are
+// made, and segments without successful speculation for the actual state are parsed sequentially.
+//
+// `ParseFunc` is called as `parse(tt, sptr0, p_sptr, rise_error)` and `SyncStatesFunc` as
+// `get_sync_states(tt, p_states)`, so `parse` and `get_sync_states` functions of the analyzer can be passed directly;
+// `StateTy` is `parser_state_t` of the analyzer
+template<typename ParseFunc, typename SyncStatesFunc, typename StateTy = int>
+class parallel_parser {
+ public:
+    parallel_parser(thread_pool& pool, ParseFunc parse, SyncStatesFunc get_sync_states, int max_reduce_length)
+        : pool_(pool), parse_(parse), get_sync_states_(get_sync_states),
+          stack_base_(static_cast<std::size_t>(std::max(max_reduce_length, 1))) {}
+
+    // Tokens are speculated in groups of at least `size` tokens
+    void set_min_chunk_size(std::size_t size) { min_chunk_size_ = std::max<std::size_t>(size, 1); }
+
+    // Parses tokens [first, last) starting with `sc` state and stores all reductions in order, like
+    // `parser_session_parse_batch()` does; returns 0 or the negative error code, then `error_index()` gives
+    // the index of the erroneous token
+    int parse(int sc, const int* first, const int* last, std::vector<reduction>& reductions);
+
+    std::size_t error_index() const { return error_index_; }
+    std::size_t segment_count() const { return segment_count_; }
+    std::size_t fallback_count() const { return fallback_count_; }
+    const std::vector<StateTy>& stack() const { return stack_; }  // The state stack after parsing
+
+ private:
+    struct speculation {
+        int state;                              // Entry state
+        int status;                             // 0 or error code
+        std::size_t stop;                       // Index of the first not processed token
+        std::size_t states_first, states_last;  // Resulting stack including entry state
+        std::size_t rd_first, rd_last;
+    };
+
+    // Range of joined reductions and its position in the output
+    struct piece {
+        const std::vector<reduction>* src;
+        std::size_t first, last;
+        std::size_t offset;
+    };
+
+    struct chunk {
+        std::vector<std::size_t> segments;  // Starting token indices
+        std::vector<std::size_t> spec_idx;  // Speculations of each segment, one extra item at the end
+        std::vector<speculation> specs;
+        std::vector<StateTy> states;
+        std::vector<reduction> reductions;
+        std::vector<StateTy> stack;
+    };
+
+    thread_pool& pool_;
+    ParseFunc parse_;
+    SyncStatesFunc get_sync_states_;
+    std::size_t stack_base_;  // Cells below the entry state catch reductions, which pop it
+    std::size_t min_chunk_size_ = 4096;
+    std::vector<chunk> chunks_;
+    std::vector<StateTy> stack_;
+    std::vector<piece> pieces_;
+    std::vector<reduction> joined_reductions_;  // Reductions made while joining
+    std::size_t error_index_ = 0;
+    std::size_t segment_count_ = 0;
+    std::size_t fallback_count_ = 0;
+
+    void speculate(chunk& ch, const int* tokens, int state, std::size_t first, std::size_t last);
+    void parse_chunk(chunk& ch, int sc, const int* tokens, std::size_t count, std::size_t first, std::size_t last);
+    int join(int sc, const int* tokens, std::size_t count, std::size_t chunk_count);
+};
+
+template<typename ParseFunc>
+struct parse_state_type {
+    using type = int;
+};
+
+template<typename StateTy>
+struct parse_state_type<int (*)(int, StateTy*, StateTy**, int)> {
+    using type = StateTy;
+};
+
+template<typename ParseFunc, typename SyncStatesFunc>
+parallel_parser(thread_pool&, ParseFunc, SyncStatesFunc, int)
+    -> parallel_parser<ParseFunc, SyncStatesFunc, typename parse_state_type<ParseFunc>::type>;
+
+template<typename ParseFunc, typename SyncStatesFunc, typename StateTy>
+void parallel_parser<ParseFunc, SyncStatesFunc, StateTy>::speculate(chunk& ch, const int* tokens, int state,
+                                                                    std::size_t first, std::size_t last) {
+    auto& stack = ch.stack;
+    if (stack.size() < stack_base_ + 64) { stack.resize(stack_base_ + 64); }
+    std::fill(stack.begin(), stack.begin() + stack_base_ + 1, static_cast<StateTy>(state));
+    StateTy* sptr = stack.data() + stack_base_ + 1;
+    speculation spec{state, 0, first, ch.states.size(), 0, ch.reductions.size(), 0};
+    while (spec.stop < last) {
+        if (sptr == stack.data() + stack.size()) {
+            const std::size_t depth = sptr - stack.data();
+            stack.resize(2 * stack.size());
+            sptr = stack.data() + depth;
+        }
+        StateTy* sptr_prev = sptr;
+        int action = parse_(tokens[spec.stop], stack.data() + stack_base_, &sptr, 0);
+        if (action < 0) {
+            spec.status = action;
+            break;
+        } else if (action == 0) {
+            ++spec.stop;
+        } else if (sptr <= stack.data() + stack_base_ + 1) {  // The entry state is popped
+            stack[stack_base_] = static_cast<StateTy>(state), sptr = sptr_prev;
+            break;
+        } else {
+            ch.reductions.push_back({action, static_cast<int>(sptr_prev - sptr) + 1, spec.stop});
+        }
+    }
+    if (spec.status == 0) {
+        ch.states.insert(ch.states.end(), stack.data() + stack_base_, sptr);
+    } else {
+        ch.reductions.resize(spec.rd_first);
+    }
+    spec.states_last = ch.states.size(), spec.rd_last = ch.reductions.size();
+    ch.specs.push_back(spec);
+}
+
+template<typename ParseFunc, typename SyncStatesFunc, typename StateTy>
+void parallel_parser<ParseFunc, SyncStatesFunc, StateTy>::parse_chunk(chunk& ch, int sc, const int* tokens,
+                                                                      std::size_t count, std::size_t first,
+                                                                      std::size_t last) {
+    const int* states = nullptr;
+    ch.segments.clear(), ch.spec_idx.clear(), ch.specs.clear();
+    ch.states.clear(), ch.reductions.clear();
+    if (first == 0) { ch.segments.push_back(0); }
+    for (std::size_t i = std::max<std::size_t>(first, 1); i < last; ++i) {
+        if (get_sync_states_(tokens[i], &states) > 0) { ch.segments.push_back(i); }
+    }
+    if (ch.segments.empty()) { return; }
+
+    // The last segment of the chunk ends at the next synchronization token
+    std::size_t next_segment = last;
+    while (next_segment < count && get_sync_states_(tokens[next_segment], &states) == 0) { ++next_segment; }
+
+    for (std::size_t n = 0; n < ch.segments.size(); ++n) {
+        const std::size_t segment_first = ch.segments[n];
+        const std::size_t segment_last = n + 1 < ch.segments.size() ? ch.segments[n + 1] : next_segment;
+        ch.spec_idx.push_back(ch.specs.size());
+        if (segment_first == 0) {
+            speculate(ch, tokens, sc, segment_first, segment_last);
+            continue;
+        }
+        int state_count = get_sync_states_(tokens[segment_first], &states);
+        for (int k = 0; k < state_count; ++k) { speculate(ch, tokens, states[k], segment_first, segment_last); }
+    }
+    ch.spec_idx.push_back(ch.specs.size());
+}
+
+template<typename ParseFunc, typename SyncStatesFunc, typename StateTy>
+int parallel_parser<ParseFunc, SyncStatesFunc, StateTy>::parse(int sc, const int* first, const int* last,
+                                                               std::vector<reduction>& reductions) {
+    const std::size_t count = last - first;
+    const std::size_t chunk_count = std::max<std::size_t>(
+        std::min<std::size_t>(count / min_chunk_size_, 4 * static_cast<std::size_t>(pool_.thread_count())), 1);
+    error_index_ = 0, segment_count_ = 0, fallback_count_ = 0;
+    if (chunks_.size() < chunk_count) { chunks_.resize(chunk_count); }
+    pool_.for_each_index(chunk_count, [this, sc, first, count, chunk_count](std::size_t n) {
+        parse_chunk(chunks_[n], sc, first, count, n * count / chunk_count, (n + 1) * count / chunk_count);
+    });
+
+    int status = join(sc, first, count, chunk_count);
+
+    // Copy joined reductions
+    std::size_t size = reductions.size();
+    for (piece& p : pieces_) { p.offset = size, size += p.last - p.first; }
+    reductions.resize(size);
+    const std::size_t batch_count = std::min(pieces_.size(), 4 * static_cast<std::size_t>(pool_.thread_count()));
+    pool_.for_each_index(batch_count, [this, batch_count, &reductions](std::size_t n) {
+        for (std::size_t k = n * pieces_.size() / batch_count; k < (n + 1) * pieces_.size() / batch_count; ++k) {
+            const piece& p = pieces_[k];
+            std::copy(p.src->begin() + p.first, p.src->begin() + p.last, reductions.begin() + p.offset);
+        }
+    });
+    return status;
+}
+
+template<typename ParseFunc, typename SyncStatesFunc, typename StateTy>
+int parallel_parser<ParseFunc, SyncStatesFunc, StateTy>::join(int sc, const int* tokens, std::size_t count,
+                                                              std::size_t chunk_count) {
+    pieces_.clear(), joined_reductions_.clear();
+    auto add_piece = [this](const std::vector<reduction>& src, std::size_t first, std::size_t last) {
+        if (first == last) { return; }
+        if (!pieces_.empty() && pieces_.back().src == &src && pieces_.back().last == first) {
+            pieces_.back().last = last;
+        } else {
+            pieces_.push_back({&src, first, last, 0});
+        }
+    };
+
+    stack_.resize(std::max<std::size_t>(stack_.size(), 64));
+    stack_[0] = static_cast<StateTy>(sc);
+    std::size_t depth = 1, tt_index = 0;
+
+    // Replaces the entry state on the top of the stack with the resulting stack of successful speculation
+    auto join_segment = [this, &depth, &tt_index, &add_piece](const chunk& ch, std::size_t n_segment,
+                                                              std::size_t depth_prev) {
+        const int state = stack_[depth_prev - 1];
+        for (std::size_t n = ch.spec_idx[n_segment]; n < ch.spec_idx[n_segment + 1]; ++n) {
+            const speculation& spec = ch.specs[n];
+            if (spec.state != state || spec.status != 0) { continue; }
+            depth = depth_prev - 1;
+            if (depth + spec.states_last - spec.states_first >= stack_.size()) {
+                stack_.resize(2 * (depth + spec.states_last - spec.states_first));
+            }
+            std::copy(ch.states.begin() + spec.states_first, ch.states.begin() + spec.states_last,
+                      stack_.begin() + depth);
+            depth += spec.states_last - spec.states_first;
+            add_piece(ch.reductions, spec.rd_first, spec.rd_last);
+            tt_index = spec.stop;
+            return true;
+        }
+        ++fallback_count_;
+        return false;
+    };
+
+    std::size_t n_chunk = 0, n_segment = 0;
+    auto next_segment = [this, &n_chunk, &n_segment, chunk_count]() -> const std::size_t* {
+        while (n_chunk < chunk_count && n_segment == chunks_[n_chunk].segments.size()) { ++n_chunk, n_segment = 0; }
+        return n_chunk < chunk_count ? &chunks_[n_chunk].segments[n_segment] : nullptr;
+    };
+
+    if (const std::size_t* segment = next_segment(); segment && *segment == 0) {
+        ++segment_count_;
+        join_segment(chunks_[n_chunk], n_segment++, depth);
+    }
+    while (tt_index < count) {
+        if (depth == stack_.size()) { stack_.resize(2 * stack_.size()); }
+        StateTy* sptr = stack_.data() + depth;
+        int action = parse_(tokens[tt_index], stack_.data(), &sptr, 0);
+        const std::size_t depth_prev = depth;
+        depth = sptr - stack_.data();
+        if (action < 0) {
+            error_index_ = tt_index;
+            stack_.resize(depth);
+            return action;
+        } else if (action != 0) {
+            joined_reductions_.push_back({action, static_cast<int>(depth_prev - depth) + 1, tt_index});
+            add_piece(joined_reductions_, joined_reductions_.size() - 1, joined_reductions_.size());
+        } else if (const std::size_t* segment = next_segment(); segment && *segment == tt_index) {
+            ++segment_count_;
+            if (!join_segment(chunks_[n_chunk], n_segment++, depth_prev)) { ++tt_index; }
+        } else {
+            ++tt_index;
+        }
+    }
+    stack_.resize(depth);
+    return 0;
+}
+
+}  // namespace parsegen
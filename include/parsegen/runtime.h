@@ -0,0 +1,231 @@
+#pragma once
+
+/* Parsegen runtime for binary tables written with `--binary-out` option */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* All values are little-endian 32-bit integers, sections are aligned to 8 bytes */
+enum {
+    parsegen_tables_magic = 0x42544750, /* `PGTB` */
+    parsegen_tables_version = 2,
+    parsegen_tables_alignment = 8,
+    parsegen_predef_tt_error = 258,
+    parsegen_predef_act_shift = 0,
+    parsegen_predef_act_reduce = 1,
+    parsegen_invalid_tables = -3 /* Returned by `parsegen_parse()` if a reduction pops the starting state */
+};
+
+enum parsegen_section_id {
+    parsegen_section_default_reduce = 0, /* Default reduction action for each state or -1 */
+    parsegen_section_action_idx,         /* Index of state row in `action_list` */
+    parsegen_section_action_list,        /* (token, action) pairs, each row ends with (-1, default action) */
+    parsegen_section_reduce_info,        /* (length, index of row in `goto_list`, action) for each production */
+    parsegen_section_goto_list,          /* (state, new state) pairs, each row ends with (-1, default new state) */
+    parsegen_section_error_shift,        /* New state after `$error` token shift for each state or -1 */
+    parsegen_section_recovery_idx,       /* Index of bitmap of tokens accepted after `$error` shift or -1 */
+    parsegen_section_recovery_tokens,    /* Bitmap row size in 32-bit words followed by bitmap rows */
+    parsegen_section_token_names,        /* (token identifier, offset of name in `strings`) pairs */
+    parsegen_section_action_names,       /* (action identifier, offset of name in `strings`) pairs */
+    parsegen_section_start_conditions,   /* (starting state, offset of name in `strings`) pairs */
+    parsegen_section_strings,            /* Zero-terminated names */
+    parsegen_section_count
+};
+
+struct parsegen_tables_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t section_count;
+    struct {
+        uint32_t offset; /* From the beginning of tables */
+        uint32_t count;  /* Number of values, or number of bytes for `strings` */
+    } sections[parsegen_section_count];
+};
+
+/* Sections of loaded tables, which point into the original memory */
+struct parsegen_tables {
+    const int32_t* data[parsegen_section_count];
+    uint32_t count[parsegen_section_count];
+};
+
+static inline int parsegen_check_row(const struct parsegen_tables* tbls, enum parsegen_section_id section,
+                                     int32_t idx) {
+    const int32_t* list = tbls->data[section];
+    uint32_t count = tbls->count[section];
+    if (idx < 0 || (idx & 1) || (uint32_t)idx >= count) { return 0; }
+    while (list[idx] >= 0) {
+        if ((idx += 2) >= (int32_t)count) { return 0; }
+    }
+    return 1;
+}
+
+static inline int parsegen_check_action(const struct parsegen_tables* tbls, int32_t action) {
+    if (action < 0) { return 1; }
+    if (action & 1) { return (uint32_t)(action >> 1) < tbls->count[parsegen_section_default_reduce]; }
+    return (uint32_t)(action >> 1) < tbls->count[parsegen_section_reduce_info] / 3;
+}
+
+static inline int parsegen_check_names(const struct parsegen_tables* tbls, enum parsegen_section_id section) {
+    const int32_t* names = tbls->data[section];
+    uint32_t i;
+    if (tbls->count[section] & 1) { return 0; }
+    for (i = 0; i < tbls->count[section]; i += 2) {
+        if (names[i + 1] < 0 || (uint32_t)names[i + 1] >= tbls->count[parsegen_section_strings]) { return 0; }
+    }
+    return 1;
+}
+
+/* Checks that all table indices are in range, reduction lengths are checked against the stack by `parsegen_parse()` */
+static inline int parsegen_check_tables(const struct parsegen_tables* tbls) {
+    uint32_t state_count = tbls->count[parsegen_section_default_reduce], i;
+    const int32_t* recovery_tokens = tbls->data[parsegen_section_recovery_tokens];
+    const int32_t* strings = tbls->data[parsegen_section_strings];
+    if (!state_count || tbls->count[parsegen_section_action_idx] != state_count ||
+        (tbls->count[parsegen_section_action_list] & 1) || (tbls->count[parsegen_section_goto_list] & 1) ||
+        tbls->count[parsegen_section_reduce_info] % 3 != 0) {
+        return 0;
+    }
+    for (i = 0; i < state_count; ++i) {
+        int32_t action = tbls->data[parsegen_section_default_reduce][i];
+        if ((action >= 0 && (action & 1)) || !parsegen_check_action(tbls, action) ||
+            !parsegen_check_row(tbls, parsegen_section_action_list, tbls->data[parsegen_section_action_idx][i])) {
+            return 0;
+        }
+    }
+    for (i = 1; i < tbls->count[parsegen_section_action_list]; i += 2) {
+        if (!parsegen_check_action(tbls, tbls->data[parsegen_section_action_list][i])) { return 0; }
+    }
+    for (i = 0; i < tbls->count[parsegen_section_reduce_info]; i += 3) {
+        const int32_t* info = &tbls->data[parsegen_section_reduce_info][i];
+        if (info[0] < 0 || info[2] < 0 || !parsegen_check_row(tbls, parsegen_section_goto_list, info[1])) { return 0; }
+    }
+    for (i = 1; i < tbls->count[parsegen_section_goto_list]; i += 2) {
+        int32_t state = tbls->data[parsegen_section_goto_list][i];
+        if (state < 0 || (uint32_t)state >= state_count) { return 0; }
+    }
+    if (tbls->count[parsegen_section_error_shift] != state_count ||
+        tbls->count[parsegen_section_recovery_idx] != state_count || !tbls->count[parsegen_section_recovery_tokens] ||
+        recovery_tokens[0] < 0) {
+        return 0;
+    }
+    for (i = 0; i < state_count; ++i) {
+        uint32_t recovery_count = tbls->count[parsegen_section_recovery_tokens];
+        int32_t state = tbls->data[parsegen_section_error_shift][i], idx = tbls->data[parsegen_section_recovery_idx][i];
+        if ((state >= 0 && (uint32_t)state >= state_count) ||
+            (idx >= 0 && (idx < 1 || (uint32_t)idx > recovery_count ||
+                          (uint32_t)recovery_tokens[0] > recovery_count - (uint32_t)idx))) {
+            return 0;
+        }
+    }
+    for (i = 0; i < tbls->count[parsegen_section_start_conditions]; i += 2) {
+        int32_t state = tbls->data[parsegen_section_start_conditions][i];
+        if (state < 0 || (uint32_t)state >= state_count) { return 0; }
+    }
+    return tbls->count[parsegen_section_strings] &&
+           ((const char*)strings)[tbls->count[parsegen_section_strings] - 1] == '\0' &&
+           parsegen_check_names(tbls, parsegen_section_token_names) &&
+           parsegen_check_names(tbls, parsegen_section_action_names) &&
+           parsegen_check_names(tbls, parsegen_section_start_conditions);
+}
+
+/* Points `tbls` into tables at `data`, which must stay valid, returns 0 on success or -1 if tables are invalid */
+static inline int parsegen_load_tables(struct parsegen_tables* tbls, const void* data, size_t size) {
+    const struct parsegen_tables_header* header = (const struct parsegen_tables_header*)data;
+    const uint32_t byte_order_check = 1;
+    unsigned n;
+    if (*(const unsigned char*)&byte_order_check != 1) { return -1; } /* Tables are used in place */
+    if ((uintptr_t)data % parsegen_tables_alignment || size < sizeof(*header)) { return -1; }
+    if (header->magic != parsegen_tables_magic || header->version != parsegen_tables_version ||
+        header->size > size || header->section_count != parsegen_section_count) {
+        return -1;
+    }
+    for (n = 0; n < parsegen_section_count; ++n) {
+        uint32_t offset = header->sections[n].offset, count = header->sections[n].count;
+        uint32_t value_size = n == parsegen_section_strings ? 1 : sizeof(int32_t);
+        if (offset % parsegen_tables_alignment || offset > header->size ||
+            count > (header->size - offset) / value_size) {
+            return -1;
+        }
+        tbls->data[n] = (const int32_t*)((const char*)data + offset);
+        tbls->count[n] = count;
+    }
+    return parsegen_check_tables(tbls) ? 0 : -1;
+}
+
+/* Returns the name of token, action or start condition with identifier `id`, or NULL */
+static inline const char* parsegen_get_name(const struct parsegen_tables* tbls, enum parsegen_section_id section,
+                                            int id) {
+    const int32_t* names = tbls->data[section];
+    uint32_t i;
+    for (i = 0; i < tbls->count[section]; i += 2) {
+        if (names[i] == id) { return (const char*)tbls->data[parsegen_section_strings] + names[i + 1]; }
+    }
+    return NULL;
+}
+
+/* Returns the identifier of token, action or start condition with `name`, or -1 */
+static inline int parsegen_find_name(const struct parsegen_tables* tbls, enum parsegen_section_id section,
+                                     const char* name) {
+    const int32_t* names = tbls->data[section];
+    uint32_t i;
+    for (i = 0; i < tbls->count[section]; i += 2) {
+        if (!strcmp((const char*)tbls->data[parsegen_section_strings] + names[i + 1], name)) { return names[i]; }
+    }
+    return -1;
+}
+
+static inline int parsegen_need_lookahead(const struct parsegen_tables* tbls, const int* sptr) {
+    return tbls->data[parsegen_section_default_reduce][*(sptr - 1)] < 0;
+}
+
+/* The same as `parse()` function of the analyzer file */
+static inline int parsegen_parse(const struct parsegen_tables* tbls, int tt, int* sptr0, int** p_sptr,
+                                 int rise_error) {
+    enum { shift_flag = 1, flag_count = 1 };
+    const int32_t* action_idx = tbls->data[parsegen_section_action_idx];
+    const int32_t* action_list = tbls->data[parsegen_section_action_list];
+    int* sptr = *p_sptr;
+    int action = rise_error;
+    if (action >= 0 && (action = tbls->data[parsegen_section_default_reduce][*(sptr - 1)]) < 0) {
+        int i = action_idx[*(sptr - 1)];
+        while (action_list[i] >= 0 && action_list[i] != tt) { i += 2; }
+        action = action_list[i + 1];
+    }
+    if (action >= 0) {
+        if (!(action & shift_flag)) {
+            const int32_t* info = &tbls->data[parsegen_section_reduce_info][3 * (action >> flag_count)];
+            const int32_t* goto_list = tbls->data[parsegen_section_goto_list];
+            int i = info[1], state;
+            if (info[0] >= sptr - sptr0) { return parsegen_invalid_tables; } /* Never happens with valid tables */
+            state = *((sptr -= info[0]) - 1);
+            while (goto_list[i] >= 0 && goto_list[i] != state) { i += 2; }
+            *sptr++ = goto_list[i + 1];
+            *p_sptr = sptr;
+            return parsegen_predef_act_reduce + info[2];
+        }
+        *sptr++ = action >> flag_count;
+        *p_sptr = sptr;
+        return parsegen_predef_act_shift;
+    }
+    /* Roll back to state, which can accept error */
+    do {
+        int state = tbls->data[parsegen_section_error_shift][*(sptr - 1)];
+        if (state >= 0) {    /* Can recover */
+            *sptr++ = state; /* Shift error token */
+            break;
+        }
+    } while (--sptr != sptr0);
+    *p_sptr = sptr;
+    return action;
+}
+
+/* The same as `is_recovery_token()` function of the analyzer file, returns 0 for unknown tokens */
+static inline int parsegen_is_recovery_token(const struct parsegen_tables* tbls, const int* sptr, int tt) {
+    const int32_t* recovery_tokens = tbls->data[parsegen_section_recovery_tokens];
+    int i = tbls->data[parsegen_section_recovery_idx][*(sptr - 1)];
+    if (i < 0) { return 1; }
+    if (tt < 0 || (uint32_t)(tt >> 5) >= (uint32_t)recovery_tokens[0]) { return 0; }
+    return ((uint32_t)recovery_tokens[i + (tt >> 5)] >> (tt & 31)) & 1;
+}
@@ -14,7 +14,7 @@ Grammar::Grammar(std::string file_name) : file_name_(std::move(file_name)) {
 
 std::pair<unsigned, bool> Grammar::addToken(std::string name) {
     unsigned id = static_cast<unsigned>(tokens_.size());
-    if (id > ValueSet::kMaxValue) { throw std::runtime_error("too many tokens"); }
+    if (id > kMaxSymbolIndex) { throw std::runtime_error("too many tokens"); }
     auto result = symbol_tbl_.insertName(std::move(name), id);
     if (!result.second) { return result; }
     tokens_.emplace_back();
@@ -22,7 +22,7 @@ std::pair<unsigned, bool> Grammar::addToken(std::string name) {
 }
 
 std::pair<unsigned, bool> Grammar::addNonterm(std::string name) {
-    if (nonterm_count_ > ValueSet::kMaxValue) { throw std::runtime_error("too many nonterminals"); }
+    if (nonterm_count_ > kMaxSymbolIndex) { throw std::runtime_error("too many nonterminals"); }
     auto result = symbol_tbl_.insertName(std::move(name), makeNontermId(nonterm_count_));
     if (!result.second) { return result; }
     ++nonterm_count_;
@@ -30,7 +30,7 @@ std::pair<unsigned, bool> Grammar::addNonterm(std::string name) {
 }
 
 std::pair<unsigned, bool> Grammar::addAction(std::string name) {
-    if (action_count_ > ValueSet::kMaxValue) { throw std::runtime_error("too many actions"); }
+    if (action_count_ > kMaxSymbolIndex) { throw std::runtime_error("too many actions"); }
     auto result = action_tbl_.insertName(std::move(name), makeActionId(action_count_));
     if (!result.second) { return result; }
     ++action_count_;
@@ -44,6 +44,12 @@ bool Grammar::setTokenPrecAndAssoc(unsigned id, int prec, Assoc assoc) {
     return true;
 }
 
+bool Grammar::addSyncToken(unsigned id) {
+    if (sync_tokens_.contains(id)) { return false; }
+    sync_tokens_.addValue(id);
+    return true;
+}
+
 Grammar::ProductionInfo& Grammar::addProduction(unsigned lhs, std::vector<unsigned> rhs, int prec) {
     if (prec < 0) {  // Calculate default precedence from the last token
         if (auto [it, found] = uxs::find_if(uxs::make_reverse_range(rhs), isToken); found) { prec = tokens_[*it].prec; }
@@ -134,6 +140,7 @@ void Grammar::printTokens(uxs::iobuf& outp) const {
                     case Assoc::kRight: uxs::print(outp, " %right"); break;
                 }
             }
+            if (sync_tokens_.contains(id)) { uxs::print(outp, " %sync"); }
             outp.endl();
         }
     }
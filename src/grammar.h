@@ -16,12 +16,17 @@ enum {
 
 enum class Assoc { kNone = 0, kLeft, kRight };
 
-constexpr bool isNonterm(unsigned id) { return id & 0x1000; }
-constexpr bool isAction(unsigned id) { return id & 0x2000; }
-constexpr bool isToken(unsigned id) { return !(id & 0x3000); }
-constexpr unsigned getIndex(unsigned id) { return id & ~0x3000; }
-constexpr unsigned makeNontermId(unsigned index) { return 0x1000 + index; }
-constexpr unsigned makeActionId(unsigned index) { return 0x2000 + index; }
+// Symbol kind is kept in two upper bits of symbol identifier, the rest is the index of token,
+// nonterminal or action, so tokens are identified by their indices
+const unsigned kSymbolIndexBits = 30;
+const unsigned kMaxSymbolIndex = (1u << kSymbolIndexBits) - 1;
+
+constexpr bool isNonterm(unsigned id) { return (id >> kSymbolIndexBits) == 1; }
+constexpr bool isAction(unsigned id) { return (id >> kSymbolIndexBits) == 2; }
+constexpr bool isToken(unsigned id) { return (id >> kSymbolIndexBits) == 0; }
+constexpr unsigned getIndex(unsigned id) { return id & kMaxSymbolIndex; }
+constexpr unsigned makeNontermId(unsigned index) { return (1u << kSymbolIndexBits) + index; }
+constexpr unsigned makeActionId(unsigned index) { return (2u << kSymbolIndexBits) + index; }
 
 class Grammar {
  public:
@@ -46,6 +51,7 @@ class Grammar {
     std::pair<unsigned, bool> addNonterm(std::string name);
     std::pair<unsigned, bool> addAction(std::string name);
     bool setTokenPrecAndAssoc(unsigned id, int prec, Assoc assoc);
+    bool addSyncToken(unsigned id);
     ProductionInfo& addProduction(unsigned lhs, std::vector<unsigned> rhs, int prec);
     bool addStartCondition(std::string name);
     bool setStartConditionProd(std::string_view name, unsigned n_prod);
@@ -53,6 +59,7 @@ class Grammar {
     const std::string& getFileName() const { return file_name_; }
     unsigned getTokenCount() const { return static_cast<unsigned>(tokens_.size()); }
     const TokenInfo& getTokenInfo(unsigned id) const { return tokens_[id]; }
+    const ValueSet& getSyncTokens() const { return sync_tokens_; }
     unsigned getNontermCount() const { return nonterm_count_; }
     unsigned getProductionCount() const { return static_cast<unsigned>(productions_.size()); }
     const std::vector<ProductionInfo>& getProductions() const { return productions_; }
@@ -81,6 +88,7 @@ class Grammar {
     std::vector<TokenInfo> tokens_;
     std::vector<ProductionInfo> productions_;
     std::vector<std::pair<std::string, unsigned>> start_conditions_;
+    ValueSet sync_tokens_;
     ValueSet defined_nonterms_;
     ValueSet used_nonterms_;
     NameTable symbol_tbl_;
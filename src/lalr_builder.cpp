@@ -5,39 +5,384 @@
 #include <uxs/algorithm.h>
 #include <uxs/io/oflatbuf.h>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+std::size_t hashCombine(std::size_t hash, unsigned v) {
+    return hash ^ (v + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+// DeRemer & Pennello `digraph` algorithm: calculates `F(x) = F'(x) U { F(y) : x R y }` for
+// each node `x` traversing strongly connected components of relation `R` only once.
+// Initially `f` contains `F'` sets, on return it contains `F` sets
+void digraph(const std::vector<std::vector<unsigned>>& rel, std::vector<ValueSet>& f) {
+    const unsigned kInfinity = ~0u;
+    struct Frame {
+        unsigned x, n_edge, depth;
+    };
+    std::vector<unsigned> depth(rel.size(), 0), stack;
+    std::vector<Frame> frames;
+    stack.reserve(rel.size());
+    auto enter = [&depth, &stack, &frames](unsigned x) {
+        stack.push_back(x);
+        depth[x] = static_cast<unsigned>(stack.size());
+        frames.push_back(Frame{x, 0, depth[x]});
+    };
+    for (unsigned x0 = 0; x0 < rel.size(); ++x0) {
+        if (depth[x0]) { continue; }
+        enter(x0);
+        do {
+            auto& frame = frames.back();
+            const unsigned x = frame.x;
+            if (frame.n_edge < rel[x].size()) {
+                unsigned y = rel[x][frame.n_edge++];
+                if (!depth[y]) {
+                    enter(y);
+                } else {
+                    depth[x] = std::min(depth[x], depth[y]);
+                    f[x] |= f[y];
+                }
+                continue;
+            }
+            if (depth[x] == frame.depth) {  // `x` is the root of strongly connected component
+                unsigned y = 0;
+                do {
+                    y = stack.back();
+                    stack.pop_back();
+                    depth[y] = kInfinity;
+                    if (y != x) { f[y] = f[x]; }
+                } while (y != x);
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                const unsigned parent = frames.back().x;
+                depth[parent] = std::min(depth[parent], depth[x]);
+                f[parent] |= f[x];
+            }
+        } while (!frames.empty());
+    }
+}
+
+// Tarjan's algorithm: calls `func` for each strongly connected component of relation `R`,
+// components are visited in reverse topological order, so `y` is visited before `x` if `x R y`
+template<typename Func>
+void forEachStronglyConnectedComponent(const std::vector<std::vector<unsigned>>& rel, const Func& func) {
+    const unsigned kInfinity = ~0u;
+    struct Frame {
+        unsigned x, n_edge, depth;
+    };
+    std::vector<unsigned> depth(rel.size(), 0), stack;
+    std::vector<Frame> frames;
+    stack.reserve(rel.size());
+    auto enter = [&depth, &stack, &frames](unsigned x) {
+        stack.push_back(x);
+        depth[x] = static_cast<unsigned>(stack.size());
+        frames.push_back(Frame{x, 0, depth[x]});
+    };
+    for (unsigned x0 = 0; x0 < rel.size(); ++x0) {
+        if (depth[x0]) { continue; }
+        enter(x0);
+        do {
+            auto& frame = frames.back();
+            const unsigned x = frame.x;
+            if (frame.n_edge < rel[x].size()) {
+                unsigned y = rel[x][frame.n_edge++];
+                if (!depth[y]) {
+                    enter(y);
+                } else {
+                    depth[x] = std::min(depth[x], depth[y]);
+                }
+                continue;
+            }
+            if (depth[x] == frame.depth) {  // `x` is the root of strongly connected component
+                auto first = stack.begin() + (frame.depth - 1);
+                for (auto it = first; it != stack.end(); ++it) { depth[*it] = kInfinity; }
+                func(std::span<const unsigned>(&*first, stack.end() - first));
+                stack.erase(first, stack.end());
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                const unsigned parent = frames.back().x;
+                depth[parent] = std::min(depth[parent], depth[x]);
+            }
+        } while (!frames.empty());
+    }
+}
+
+// Packs rows of compressed table into row displacement table using first-fit method
+template<typename Ty>
+void packCombTable(const LalrBuilder::CompressedTable<Ty>& compr_tbl, unsigned width,
+                   LalrBuilder::CombTable<Ty>& comb_tbl) {
+    // Find distinct rows and their lengths, rows are terminated with default value
+    std::vector<std::pair<unsigned, unsigned>> rows;  // (first entry, entry count) pairs
+    rows.reserve(compr_tbl.index.size());
+    std::unordered_map<unsigned, unsigned> row_base;
+    for (unsigned first : compr_tbl.index) {
+        if (!row_base.emplace(first, 0).second) { continue; }
+        unsigned last = first;
+        while (compr_tbl.data[last].first >= 0) { ++last; }
+        rows.emplace_back(first, last - first);
+    }
+
+    // Longer rows are placed first
+    std::stable_sort(rows.begin(), rows.end(), [](const auto& r1, const auto& r2) { return r1.second > r2.second; });
+
+    // Base is the identifier of the row, so all rows must have different bases
+    std::vector<bool> is_occupied, is_base_used;
+    unsigned first_free = 0, data_size = 0;
+    for (const auto& [first, count] : rows) {
+        auto entries = std::span(compr_tbl.data.data() + first, count);
+        unsigned base = count > 0 && first_free > static_cast<unsigned>(entries[0].first) ?
+                            first_free - static_cast<unsigned>(entries[0].first) :
+                            0;
+        for (;; ++base) {
+            if (base < is_base_used.size() && is_base_used[base]) { continue; }
+            if (std::none_of(entries.begin(), entries.end(), [&is_occupied, base](const auto& e) {
+                    return base + e.first < is_occupied.size() && is_occupied[base + e.first];
+                })) {
+                break;
+            }
+        }
+        row_base[first] = base;
+        if (base >= is_base_used.size()) { is_base_used.resize(base + 1, false); }
+        is_base_used[base] = true;
+        if (base + width > is_occupied.size()) { is_occupied.resize(base + width, false); }
+        for (const auto& e : entries) { is_occupied[base + e.first] = true; }
+        while (first_free < is_occupied.size() && is_occupied[first_free]) { ++first_free; }
+        data_size = std::max(data_size, base + width);
+    }
+
+    // Fill the table
+    comb_tbl.base.resize(compr_tbl.index.size());
+    comb_tbl.def.resize(compr_tbl.index.size());
+    comb_tbl.data.assign(data_size, std::make_pair(-1, Ty()));
+    for (const auto& [first, count] : rows) {
+        const unsigned base = row_base[first];
+        for (const auto& [i, val] : std::span(compr_tbl.data.data() + first, count)) {
+            comb_tbl.data[base + i] = std::make_pair(static_cast<int>(base), val);
+        }
+    }
+    for (unsigned n = 0; n < compr_tbl.index.size(); ++n) {
+        unsigned first = compr_tbl.index[n], last = first;
+        while (compr_tbl.data[last].first >= 0) { ++last; }
+        comb_tbl.base[n] = row_base[first];
+        comb_tbl.def[n] = compr_tbl.data[last].second;
+    }
+}
+
+template<typename Func>
+void parallelFor(unsigned job_count, unsigned count, const Func& func) {
+    // Range [0, count) is split into contiguous chunks, so merging per-job results in job order
+    // gives the same result as the sequential loop
+    job_count = std::max(std::min(job_count, count), 1u);
+    if (job_count == 1) { return func(0, 0, count); }
+    std::vector<std::thread> threads;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    threads.reserve(job_count);
+    for (unsigned n_job = 0; n_job < job_count; ++n_job) {
+        threads.emplace_back([&, n_job] {
+            try {
+                func(n_job, static_cast<unsigned>(static_cast<std::uint64_t>(count) * n_job / job_count),
+                     static_cast<unsigned>(static_cast<std::uint64_t>(count) * (n_job + 1) / job_count));
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) { error = std::current_exception(); }
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+    if (error) { std::rethrow_exception(error); }
+}
+}  // namespace
+
 void LalrBuilder::build() {
+    buildProductionIndex();
     buildFirstTable();
+    buildSuffixFirstTable();
     buildAetaTable();
 
     // Build LR(0) states :
-
-    std::vector<unsigned> pending_states;
     std::vector<std::vector<Action>> action_tbl;
     std::vector<std::vector<unsigned>> goto_tbl;
+    if (job_count_ > 1) {
+        buildStatesInParallel(action_tbl, goto_tbl);
+    } else {
+        buildStates(action_tbl, goto_tbl);
+    }
+
+    // Calculate closures of distinct kernel items :
+    buildItemClosures();
+
+    // Build lookahead sets :
+    kernel_la_.assign(kernel_items_.size(), ValueSet());
+    switch (lookahead_method_) {
+        case LookAheadMethod::kRelations: buildLookAheadsByRelations(action_tbl, goto_tbl); break;
+        case LookAheadMethod::kPropagation: buildLookAheadsByPropagation(action_tbl, goto_tbl); break;
+    }
+
+    // Generate actions :
+    buildActions(action_tbl);
+
+    if (eliminate_unit_prods_) { eliminateUnitProductions(action_tbl, goto_tbl); }
+    if (!grammar_.getSyncTokens().empty()) { buildSyncStates(action_tbl); }
+    buildErrorRecoveryTables(action_tbl);
+    makeCompressedTables(action_tbl, goto_tbl);
+    if (table_format_ == TableFormat::kComb) { makeCombTables(); }
+}
+
+void LalrBuilder::buildActions(std::vector<std::vector<Action>>& action_tbl) {
+    struct Conflict {
+        unsigned n_state;
+        unsigned n_prod;
+        unsigned n_prod2;  // Conflicting production or `kShiftConflict`
+        unsigned symb;
+    };
+
+    const unsigned kShiftConflict = ~0u;
+    const unsigned job_count = std::min(job_count_, getStateCount());
+    std::vector<std::vector<Conflict>> conflicts(std::max(job_count, 1u));
+
+    // States are processed independently, conflicts are reported after all in order of states
+    parallelFor(job_count, getStateCount(), [&](unsigned n_job, unsigned first_state, unsigned last_state) {
+        // Lookahead sets of reducible items are collected from kernel item closures:
+        // LA(A -> . , state) = U { spontaneous(A, k) U (propagate(A, k) ? LA(k) : {}) : k is kernel item of state }
+        std::vector<ValueSet> reduce_la(grammar_.getProductionCount());
+        std::vector<unsigned> reduce_prods;
+        auto add_reduce = [&reduce_la, &reduce_prods](unsigned n_prod, const ValueSet& la) {
+            if (la.empty()) { return; }
+            if (reduce_la[n_prod].empty()) { reduce_prods.push_back(n_prod); }
+            reduce_la[n_prod] |= la;
+        };
+
+        for (unsigned n_state = first_state; n_state < last_state; ++n_state) {
+            reduce_prods.clear();
+            for (unsigned n_item = state_first_item_[n_state]; n_item < state_first_item_[n_state + 1]; ++n_item) {
+                const auto& pos = kernel_items_[n_item];
+                if (pos.pos == grammar_.getProductionInfo(pos.n_prod).rhs.size()) {
+                    add_reduce(pos.n_prod, kernel_la_[n_item]);
+                }
+                const auto& item_closure = item_closures_[getItemIndex(pos)];
+                for (unsigned n = item_closure.first_reduce; n < item_closure.first_reduce + item_closure.reduce_count;
+                     ++n) {
+                    const auto& [n_prod, n_closure_nonterm] = closure_reduces_[n];
+                    add_reduce(n_prod, closure_nonterms_[n_closure_nonterm].la);
+                    if (closure_nonterms_[n_closure_nonterm].propagate) { add_reduce(n_prod, kernel_la_[n_item]); }
+                }
+            }
+
+            // Productions are reduced in order of their numbers
+            std::sort(reduce_prods.begin(), reduce_prods.end());
+            for (unsigned n_prod : reduce_prods) {
+                const auto& prod = grammar_.getProductionInfo(n_prod);
+                for (unsigned symb : reduce_la[n_prod]) {
+                    Action& action = action_tbl[n_state][symb];
+                    if (action.val == 0) {
+                        action = {Action::Type::kReduce, n_prod};
+                    } else if (action.type == Action::Type::kShift) {
+                        // Shift-Reduce conflict
+                        const auto& token_info = grammar_.getTokenInfo(symb);
+                        int token_prec = token_info.prec;
+                        int prod_prec = prod.prec;
+                        if (token_prec >= 0 && prod_prec >= 0) {
+                            if (prod_prec > token_prec) {
+                                action = {Action::Type::kReduce, n_prod};
+                            } else if (token_prec == prod_prec) {
+                                if (token_info.assoc == Assoc::kLeft) {
+                                    action = {Action::Type::kReduce, n_prod};
+                                } else if (token_info.assoc == Assoc::kNone) {
+                                    action = {Action::Type::kError};
+                                }
+                            }
+                        } else {
+                            conflicts[n_job].push_back(Conflict{n_state, n_prod, kShiftConflict, symb});
+                        }
+                    } else {  // Reduce-Reduce conflict
+                        conflicts[n_job].push_back(Conflict{n_state, action.val, n_prod, symb});
+                    }
+                }
+                reduce_la[n_prod].clear();
+            }
+        }
+    });
 
-    states_.reserve(100);
+    // Report conflicts
+    auto get_prod_text = [this](unsigned n_prod) {
+        uxs::oflatbuf production_text;
+        grammar_.printProduction(production_text, n_prod, std::nullopt);
+        return std::string(production_text.data(), production_text.size());
+    };
+
+    for (const auto& job_conflicts : conflicts) {
+        for (const auto& conflict : job_conflicts) {
+            if (conflict.n_prod2 == kShiftConflict) {
+                logger::warning(grammar_.getFileName())
+                    .println("shift/reduce conflict for `{}` production before `{}` look-ahead token",
+                             get_prod_text(conflict.n_prod), grammar_.symbolText(conflict.symb));
+                ++sr_conflict_count_;
+            } else {
+                logger::warning(grammar_.getFileName())
+                    .println("reduce/reduce conflict for `{}` and `{}` productions before `{}` look-ahead token",
+                             get_prod_text(conflict.n_prod), get_prod_text(conflict.n_prod2),
+                             grammar_.symbolText(conflict.symb));
+                ++rr_conflict_count_;
+            }
+        }
+    }
+}
+
+void LalrBuilder::buildStates(std::vector<std::vector<Action>>& action_tbl,
+                              std::vector<std::vector<unsigned>>& goto_tbl) {
+    std::vector<unsigned> pending_states;
+
+    kernel_items_.reserve(1000);
+    state_first_item_.reserve(100);
     action_tbl.reserve(100);
     goto_tbl.reserve(100);
     pending_states.reserve(100);
 
-    auto add_state = [&states = states_, &grammar = grammar_, &action_tbl, &goto_tbl](PositionSet s) {
-        auto [it, found] = uxs::find_if(states, [&s](const auto& s2) {
-            return s2.size() == s.size() &&
-                   std::equal(s2.begin(), s2.end(), s.begin(),
-                              [](const auto& i1, const auto& i2) { return i1.first == i2.first; });
-        });
-        if (found) { return std::make_pair(static_cast<unsigned>(it - states.begin()), false); }
+    // States are indexed by the hash of their kernel items
+    std::unordered_multimap<std::size_t, unsigned> state_index;
+    state_index.reserve(100);
+
+    auto add_state = [this, &state_index, &action_tbl, &goto_tbl](const std::vector<Position>& s) {
+        std::size_t hash = 0;
+        for (const auto& pos : s) { hash = hashCombine(hashCombine(hash, pos.n_prod), pos.pos); }
+        ++stats_.state_lookups;
+        auto [first, last] = state_index.equal_range(hash);
+        for (; first != last; ++first) {
+            auto s2 = getKernel(first->second);
+            ++stats_.state_probes;
+            if (s2.size() == s.size() && std::equal(s2.begin(), s2.end(), s.begin())) {
+                return std::make_pair(first->second, false);
+            }
+            ++stats_.state_collisions;
+        }
         // Add new state
-        states.emplace_back(std::move(s));
-        action_tbl.emplace_back(grammar.getTokenCount());
-        goto_tbl.emplace_back(grammar.getNontermCount(), 0);
-        return std::make_pair(static_cast<unsigned>(states.size()) - 1, true);
+        unsigned n_state = getStateCount();
+        state_index.emplace(hash, n_state);
+        kernel_items_.insert(kernel_items_.end(), s.begin(), s.end());
+        state_first_item_.push_back(static_cast<unsigned>(kernel_items_.size()));
+        action_tbl.emplace_back(grammar_.getTokenCount());
+        goto_tbl.emplace_back(grammar_.getNontermCount(), 0);
+        return std::make_pair(n_state, true);
     };
 
     // Add initial states
+    std::vector<Position> new_state;
+    new_state.reserve(100);
     for (const auto& sc : grammar_.getStartConditions()) {
-        pending_states.push_back(
-            add_state(makeSinglePositionSet(Position{sc.second, 0}, LookAheadSet::empty_t())).first);
+        new_state.assign(1, Position{sc.second, 0});
+        pending_states.push_back(add_state(new_state).first);
     }
 
     do {
@@ -45,9 +390,9 @@ void LalrBuilder::build() {
         pending_states.pop_back();
         // Goto for nonterminals
         for (unsigned n = 0; n < grammar_.getNontermCount(); ++n) {
-            auto new_state = calcGoto(states_[n_state], makeNontermId(n));
+            calcGoto(getKernel(n_state), makeNontermId(n), new_state);
             if (!new_state.empty()) {
-                auto [n_new_state, success] = add_state(std::move(new_state));
+                auto [n_new_state, success] = add_state(new_state);
                 if (success) { pending_states.push_back(n_new_state); }
                 goto_tbl[n_state][n] = n_new_state;
             }
@@ -55,141 +400,494 @@ void LalrBuilder::build() {
         // Goto for tokens
         for (unsigned symb = 0; symb < grammar_.getTokenCount(); ++symb) {
             if (grammar_.getTokenInfo(symb).is_used) {
-                auto new_state = calcGoto(states_[n_state], symb);
+                calcGoto(getKernel(n_state), symb, new_state);
                 if (!new_state.empty()) {
-                    auto [n_new_state, success] = add_state(std::move(new_state));
+                    auto [n_new_state, success] = add_state(new_state);
                     if (success) { pending_states.push_back(n_new_state); }
                     action_tbl[n_state][symb] = {Action::Type::kShift, n_new_state};
                 }
             }
         }
     } while (!pending_states.empty());
+}
 
-    // Build lookahead sets:
+void LalrBuilder::buildStatesInParallel(std::vector<std::vector<Action>>& action_tbl,
+                                        std::vector<std::vector<unsigned>>& goto_tbl) {
+    const unsigned kShardBits = 6, kShardCount = 1 << kShardBits;
 
-    // Calculate initial lookahead sets and generate transitions
-    // Add `$end` symbol to lookahead set of `$accept -> start` production
-    states_[0].begin()->second.la.addValue(0);
-    for (unsigned n_state = 0; n_state < states_.size(); ++n_state) {
-        for (const auto& [pos, la_set] : states_[n_state]) {
-            // [ B -> gamma . delta, # ]
-            auto closure = calcClosure(makeSinglePositionSet(pos, kTokenDefault));
-            for (const auto& [closure_pos, closure_la_set] : closure) {
-                const auto& prod = grammar_.getProductionInfo(closure_pos.n_prod);
-                if (closure_pos.pos > prod.rhs.size()) {
-                    throw std::runtime_error("invalid position");
-                } else if (closure_pos.pos == prod.rhs.size()) {
-                    continue;
+    // Concurrent state table: states are distributed among shards by the hash of their kernel items,
+    // temporary state identifier is `(index in shard << kShardBits) | shard number`
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_multimap<std::size_t, unsigned> index;
+        std::vector<Position> items;
+        std::vector<unsigned> first_item{0};
+    };
+
+    // Each worker expands states from its own queue and steals from other queues when it is empty
+    struct Worker {
+        std::mutex mutex;
+        std::deque<unsigned> queue;
+        std::vector<std::pair<unsigned, unsigned>> transitions;  // (symbol, temporary state identifier)
+        std::vector<std::array<unsigned, 3>> expanded;           // (state, first transition, transition count)
+        Statistics stats;
+    };
+
+    std::vector<Shard> shards(kShardCount);
+    std::vector<Worker> workers(job_count_);
+    std::atomic<std::size_t> pending_count{0};
+    std::atomic<bool> is_failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto add_state = [&shards, kShardCount](const std::vector<Position>& s, Statistics& stats) {
+        std::size_t hash = 0;
+        for (const auto& pos : s) { hash = hashCombine(hashCombine(hash, pos.n_prod), pos.pos); }
+        const unsigned n_shard = static_cast<unsigned>(hash & (kShardCount - 1));
+        auto& shard = shards[n_shard];
+        std::lock_guard lock(shard.mutex);
+        ++stats.state_lookups;
+        auto [first, last] = shard.index.equal_range(hash);
+        for (; first != last; ++first) {
+            auto s2_first = shard.items.begin() + shard.first_item[first->second];
+            auto s2_last = shard.items.begin() + shard.first_item[first->second + 1];
+            ++stats.state_probes;
+            if (s2_last - s2_first == static_cast<std::ptrdiff_t>(s.size()) &&
+                std::equal(s2_first, s2_last, s.begin())) {
+                return std::make_pair((first->second << kShardBits) | n_shard, false);
+            }
+            ++stats.state_collisions;
+        }
+        // Add new state
+        unsigned n_state = static_cast<unsigned>(shard.first_item.size()) - 1;
+        shard.index.emplace(hash, n_state);
+        shard.items.insert(shard.items.end(), s.begin(), s.end());
+        shard.first_item.push_back(static_cast<unsigned>(shard.items.size()));
+        return std::make_pair((n_state << kShardBits) | n_shard, true);
+    };
+
+    auto get_kernel = [&shards, kShardCount](unsigned id, std::vector<Position>& kernel) {
+        auto& shard = shards[id & (kShardCount - 1)];
+        std::lock_guard lock(shard.mutex);
+        kernel.assign(shard.items.begin() + shard.first_item[id >> kShardBits],
+                      shard.items.begin() + shard.first_item[(id >> kShardBits) + 1]);
+    };
+
+    auto pop_state = [&workers](unsigned n_worker) -> std::optional<unsigned> {
+        for (unsigned k = 0; k < workers.size(); ++k) {
+            auto& worker = workers[(n_worker + k) % workers.size()];
+            std::lock_guard lock(worker.mutex);
+            if (worker.queue.empty()) { continue; }
+            unsigned id = 0;
+            if (k == 0) {  // Own queue
+                id = worker.queue.back();
+                worker.queue.pop_back();
+            } else {  // Steal from other worker
+                id = worker.queue.front();
+                worker.queue.pop_front();
+            }
+            return id;
+        }
+        return std::nullopt;
+    };
+
+    auto expand_states = [&](unsigned n_worker) {
+        auto& worker = workers[n_worker];
+        std::vector<Position> kernel, new_state;
+        kernel.reserve(100);
+        new_state.reserve(100);
+        auto add_transition = [&](unsigned symb) {
+            calcGoto(kernel, symb, new_state);
+            if (new_state.empty()) { return; }
+            auto [id, success] = add_state(new_state, worker.stats);
+            if (success) {
+                ++pending_count;
+                std::lock_guard lock(worker.mutex);
+                worker.queue.push_back(id);
+            }
+            worker.transitions.emplace_back(symb, id);
+        };
+        while (!is_failed) {
+            auto id = pop_state(n_worker);
+            if (!id) {
+                if (pending_count == 0) { break; }
+                std::this_thread::yield();
+                continue;
+            }
+            try {
+                get_kernel(*id, kernel);
+                const unsigned first_transition = static_cast<unsigned>(worker.transitions.size());
+                // Goto for nonterminals
+                for (unsigned n = 0; n < grammar_.getNontermCount(); ++n) { add_transition(makeNontermId(n)); }
+                // Goto for tokens
+                for (unsigned symb = 0; symb < grammar_.getTokenCount(); ++symb) {
+                    if (grammar_.getTokenInfo(symb).is_used) { add_transition(symb); }
                 }
-                unsigned goto_state = 0;
-                unsigned next_symb = prod.rhs[closure_pos.pos];
-                if (isNonterm(next_symb)) {
-                    goto_state = goto_tbl[n_state][getIndex(next_symb)];
-                } else if (action_tbl[n_state][next_symb].type == Action::Type::kShift) {
-                    goto_state = action_tbl[n_state][next_symb].val;
+                worker.expanded.push_back(
+                    {*id, first_transition, static_cast<unsigned>(worker.transitions.size()) - first_transition});
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) { error = std::current_exception(); }
+                is_failed = true;
+            }
+            --pending_count;
+        }
+    };
+
+    // Add initial states
+    std::vector<unsigned> start_states;
+    std::vector<Position> new_state;
+    for (const auto& sc : grammar_.getStartConditions()) {
+        new_state.assign(1, Position{sc.second, 0});
+        auto [id, success] = add_state(new_state, stats_);
+        if (success) {
+            ++pending_count;
+            workers[0].queue.push_back(id);
+        }
+        start_states.push_back(id);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(job_count_ - 1);
+    for (unsigned n_worker = 1; n_worker < job_count_; ++n_worker) { threads.emplace_back(expand_states, n_worker); }
+    expand_states(0);
+    for (auto& thread : threads) { thread.join(); }
+    if (error) { std::rethrow_exception(error); }
+
+    // Collect results
+    std::vector<unsigned> shard_base(kShardCount + 1, 0);
+    for (unsigned n_shard = 0; n_shard < kShardCount; ++n_shard) {
+        shard_base[n_shard + 1] = shard_base[n_shard] + static_cast<unsigned>(shards[n_shard].first_item.size()) - 1;
+    }
+    auto dense_index = [&shard_base, kShardCount](unsigned id) {
+        return shard_base[id & (kShardCount - 1)] + (id >> kShardBits);
+    };
+
+    const unsigned state_count = shard_base.back();
+    std::vector<std::pair<const Worker*, std::array<unsigned, 3>>> expanded(state_count);
+    for (const auto& worker : workers) {
+        stats_.state_lookups += worker.stats.state_lookups;
+        stats_.state_probes += worker.stats.state_probes;
+        stats_.state_collisions += worker.stats.state_collisions;
+        for (const auto& e : worker.expanded) { expanded[dense_index(e[0])] = std::make_pair(&worker, e); }
+    }
+
+    // Number states in the same order as the sequential builder does
+    const unsigned kNone = ~0u;
+    std::vector<unsigned> state_numbers(state_count, kNone), state_ids;
+    std::vector<unsigned> pending_states;
+    state_ids.reserve(state_count);
+    pending_states.reserve(100);
+    auto number_state = [&state_numbers, &state_ids, &pending_states, &dense_index, kNone](unsigned id) {
+        if (state_numbers[dense_index(id)] != kNone) { return false; }
+        state_numbers[dense_index(id)] = static_cast<unsigned>(state_ids.size());
+        state_ids.push_back(id);
+        pending_states.push_back(id);
+        return true;
+    };
+    for (unsigned id : start_states) {
+        if (!number_state(id)) { pending_states.push_back(id); }
+    }
+    do {
+        const auto& [worker, e] = expanded[dense_index(pending_states.back())];
+        pending_states.pop_back();
+        for (unsigned n = e[1]; n < e[1] + e[2]; ++n) { number_state(worker->transitions[n].second); }
+    } while (!pending_states.empty());
+
+    // Fill kernel items and transition tables
+    action_tbl.resize(state_count, std::vector<Action>(grammar_.getTokenCount()));
+    goto_tbl.resize(state_count, std::vector<unsigned>(grammar_.getNontermCount(), 0));
+    state_first_item_.reserve(state_count + 1);
+    for (unsigned n_state = 0; n_state < state_count; ++n_state) {
+        unsigned id = state_ids[n_state];
+        const auto& shard = shards[id & (kShardCount - 1)];
+        kernel_items_.insert(kernel_items_.end(), shard.items.begin() + shard.first_item[id >> kShardBits],
+                             shard.items.begin() + shard.first_item[(id >> kShardBits) + 1]);
+        state_first_item_.push_back(static_cast<unsigned>(kernel_items_.size()));
+        const auto& [worker, e] = expanded[dense_index(id)];
+        for (unsigned n = e[1]; n < e[1] + e[2]; ++n) {
+            const auto& [symb, target_id] = worker->transitions[n];
+            unsigned n_new_state = state_numbers[dense_index(target_id)];
+            if (isNonterm(symb)) {
+                goto_tbl[n_state][getIndex(symb)] = n_new_state;
+            } else {
+                action_tbl[n_state][symb] = {Action::Type::kShift, n_new_state};
+            }
+        }
+    }
+}
+
+void LalrBuilder::buildLookAheadsByRelations(const std::vector<std::vector<Action>>& action_tbl,
+                                             const std::vector<std::vector<unsigned>>& goto_tbl) {
+    // Enumerate nonterminal transitions `(p, A)`, they are sorted by state and nonterminal
+    std::vector<std::pair<unsigned, unsigned>> transitions;
+    std::vector<unsigned> first_transition(getStateCount() + 1);
+    for (unsigned n_state = 0; n_state < getStateCount(); ++n_state) {
+        first_transition[n_state] = static_cast<unsigned>(transitions.size());
+        for (unsigned n = 0; n < grammar_.getNontermCount(); ++n) {
+            if (goto_tbl[n_state][n] > 0) { transitions.emplace_back(n_state, n); }
+        }
+    }
+    first_transition.back() = static_cast<unsigned>(transitions.size());
+
+    auto find_transition = [&transitions, &first_transition](unsigned n_state, unsigned n) {
+        auto first = transitions.begin() + first_transition[n_state];
+        auto last = transitions.begin() + first_transition[n_state + 1];
+        auto it = std::lower_bound(first, last, n, [](const auto& t, unsigned n) { return t.second < n; });
+        if (it == last || it->second != n) { throw std::runtime_error("can't find nonterminal transition"); }
+        return static_cast<unsigned>(it - transitions.begin());
+    };
+
+    auto next_state = [&action_tbl, &goto_tbl](unsigned n_state, unsigned symb) {
+        return getNextState(action_tbl, goto_tbl, n_state, symb);
+    };
+
+    // Direct read sets: DR(p, A) = { t : p --A--> r --t--> }
+    std::vector<ValueSet> shifted_tokens(getStateCount());
+    for (unsigned n_state = 0; n_state < getStateCount(); ++n_state) {
+        for (unsigned symb = 0; symb < grammar_.getTokenCount(); ++symb) {
+            if (action_tbl[n_state][symb].type == Action::Type::kShift) { shifted_tokens[n_state].addValue(symb); }
+        }
+    }
+
+    // Relation `reads`: (p, A) reads (r, C) iff p --A--> r --C--> and C =>* $empty
+    std::vector<ValueSet> follow(transitions.size());
+    std::vector<std::vector<unsigned>> rel(transitions.size());
+    for (unsigned n_trans = 0; n_trans < transitions.size(); ++n_trans) {
+        const auto& [n_state, n] = transitions[n_trans];
+        unsigned goto_state = goto_tbl[n_state][n];
+        follow[n_trans] = shifted_tokens[goto_state];
+        for (unsigned n_trans2 = first_transition[goto_state]; n_trans2 < first_transition[goto_state + 1];
+             ++n_trans2) {
+            if (first_tbl_[transitions[n_trans2].second].contains(kTokenEmpty)) { rel[n_trans].push_back(n_trans2); }
+        }
+    }
+
+    // Read(p, A) = DR(p, A) U { Read(r, C) : (p, A) reads (r, C) }
+    digraph(rel, follow);
+
+    // Relation `includes`: (p, A) includes (p', B) iff B -> beta A gamma, gamma =>* $empty and p' --beta--> p
+    for (auto& edges : rel) { edges.clear(); }
+    for (unsigned n_trans = 0; n_trans < transitions.size(); ++n_trans) {
+        const auto& [n_start_state, n] = transitions[n_trans];
+        for (unsigned n_prod : getNontermProductions(n)) {
+            const auto& rhs = grammar_.getProductionInfo(n_prod).rhs;
+            unsigned n_state = n_start_state;
+            for (unsigned pos = 0; pos < rhs.size(); ++pos) {
+                if (isNonterm(rhs[pos]) && isSuffixNullable(n_prod, pos + 1)) {
+                    rel[find_transition(n_state, getIndex(rhs[pos]))].push_back(n_trans);
                 }
-                if (goto_state == 0) { throw std::runtime_error("invalid goto state"); }
+                n_state = next_state(n_state, rhs[pos]);
+            }
+        }
+    }
+
+    // Follow(p, A) = Read(p, A) U { Follow(p', B) : (p, A) includes (p', B) }
+    digraph(rel, follow);
+
+    // Relation `lookback`: kernel item `B -> beta . gamma` of state q looks back to (p', B) iff p' --beta--> q,
+    // so its lookahead set includes Follow(p', B)
+    auto lookback = [this, &next_state](unsigned n_state, unsigned n_prod, const ValueSet& la) {
+        const auto& rhs = grammar_.getProductionInfo(n_prod).rhs;
+        for (unsigned pos = 0; pos < rhs.size(); ++pos) {
+            n_state = next_state(n_state, rhs[pos]);
+            kernel_la_[findKernelItem(n_state, {n_prod, pos + 1})] |= la;
+        }
+    };
+
+    for (unsigned n_trans = 0; n_trans < transitions.size(); ++n_trans) {
+        const auto& [n_state, n] = transitions[n_trans];
+        for (unsigned n_prod : getNontermProductions(n)) { lookback(n_state, n_prod, follow[n_trans]); }
+    }
 
-                // `A -> alpha . X beta` -> `A -> alpha X . beta`
-                ValueSet la = closure_la_set.la;
-                auto it = states_[goto_state].find({closure_pos.n_prod, closure_pos.pos + 1});
-                if (it == states_[goto_state].end()) {
-                    throw std::runtime_error("can't find state for the next position");
+    // Add `$end` symbol to lookahead set of `$accept -> start` production
+    kernel_la_[0].addValue(0);
+    lookback(0, kernel_items_[0].n_prod, kernel_la_[0]);
+}
+
+void LalrBuilder::buildLookAheadsByPropagation(const std::vector<std::vector<Action>>& action_tbl,
+                                               const std::vector<std::vector<unsigned>>& goto_tbl) {
+    // Calculate initial lookahead sets and generate transitions
+    // Add `$end` symbol to lookahead set of `$accept -> start` production
+    kernel_la_[0].addValue(0);
+
+    // Successor items are shared between states, so spontaneous lookaheads and propagation edges
+    // are buffered per job and merged afterwards
+    struct SeedBuffer {
+        std::vector<std::pair<unsigned, unsigned>> accept_la_from;  // (to item, from item) pairs
+        std::vector<std::pair<unsigned, const ValueSet*>> spontaneous;
+    };
+
+    std::vector<SeedBuffer> seeds(std::max(std::min(job_count_, getStateCount()), 1u));
+    parallelFor(job_count_, getStateCount(), [&](unsigned n_job, unsigned first_state, unsigned last_state) {
+        auto& [accept_la_from, spontaneous] = seeds[n_job];
+        for (unsigned n_state = first_state; n_state < last_state; ++n_state) {
+            for (unsigned n_item = state_first_item_[n_state]; n_item < state_first_item_[n_state + 1]; ++n_item) {
+                // [ B -> gamma . delta, # ]
+                const auto& pos = kernel_items_[n_item];
+                const auto& prod = grammar_.getProductionInfo(pos.n_prod);
+                if (pos.pos < prod.rhs.size()) {
+                    // `B -> gamma . X delta` -> `B -> gamma X . delta`
+                    unsigned goto_state = getNextState(action_tbl, goto_tbl, n_state, prod.rhs[pos.pos]);
+                    accept_la_from.emplace_back(findKernelItem(goto_state, {pos.n_prod, pos.pos + 1}), n_item);
                 }
-                if (la.contains(kTokenDefault)) {
-                    it->second.accept_la_from.push_back(&la_set);
-                    la.removeValue(kTokenDefault);
+                const auto& item_closure = item_closures_[getItemIndex(pos)];
+                for (unsigned n = item_closure.first_nonterm;
+                     n < item_closure.first_nonterm + item_closure.nonterm_count; ++n) {
+                    const auto& closure_nonterm = closure_nonterms_[n];
+                    for (unsigned n_prod : getNontermProductions(closure_nonterm.n)) {
+                        const auto& rhs = grammar_.getProductionInfo(n_prod).rhs;
+                        if (rhs.empty()) { continue; }
+                        // `A -> . X beta` -> `A -> X . beta`
+                        unsigned goto_state = getNextState(action_tbl, goto_tbl, n_state, rhs[0]);
+                        unsigned n_next_item = findKernelItem(goto_state, {n_prod, 1});
+                        if (closure_nonterm.propagate) { accept_la_from.emplace_back(n_next_item, n_item); }
+                        if (!closure_nonterm.la.empty()) { spontaneous.emplace_back(n_next_item, &closure_nonterm.la); }
+                    }
                 }
-                it->second.la |= la;
             }
         }
+    });
+
+    std::vector<std::pair<unsigned, unsigned>> accept_la_from;
+    accept_la_from.reserve(kernel_items_.size());
+    for (const auto& seed : seeds) {
+        accept_la_from.insert(accept_la_from.end(), seed.accept_la_from.begin(), seed.accept_la_from.end());
+        for (const auto& [n_item, la] : seed.spontaneous) { kernel_la_[n_item] |= *la; }
     }
+
     // Start transition iterations
     bool change = false;
     do {
         change = false;
-        for (auto& state : states_) {
-            for (auto& [pos, la_set] : state) {
-                // Accept lookahead characters
-                for (const auto* accept_from : la_set.accept_la_from) {
-                    ValueSet old_la = la_set.la;
-                    la_set.la |= accept_from->la;
-                    if (la_set.la != old_la) { change = true; }
-                }
-            }
+        for (const auto& [n_item, n_from_item] : accept_la_from) {
+            // Accept lookahead characters
+            if (kernel_la_[n_item].orChanged(kernel_la_[n_from_item])) { change = true; }
         }
     } while (change);
+}
 
-    // Generate actions :
-    auto get_prod_text = [this](unsigned n_prod) {
-        uxs::oflatbuf production_text;
-        grammar_.printProduction(production_text, n_prod, std::nullopt);
-        return std::string(production_text.data(), production_text.size());
-    };
-
-    for (unsigned n_state = 0; n_state < states_.size(); ++n_state) {
-        for (const auto& [pos, la_set] : calcClosure(states_[n_state])) {
-            const auto& prod = grammar_.getProductionInfo(pos.n_prod);
-            if (pos.pos > prod.rhs.size()) {
-                throw std::runtime_error("invalid position");
-            } else if (pos.pos != prod.rhs.size()) {  // Not final position
-                continue;
+void LalrBuilder::eliminateUnitProductions(const std::vector<std::vector<Action>>& action_tbl,
+                                           std::vector<std::vector<unsigned>>& goto_tbl) {
+    // Find states, which reduce unit production `A -> B` without action regardless of look-ahead token
+    const unsigned kNone = ~0u;
+    std::vector<unsigned> unit_prods(action_tbl.size(), kNone);
+    for (unsigned n_state = 0; n_state < action_tbl.size(); ++n_state) {
+        unsigned n_reduce_prod = kNone;
+        bool is_consistent = true;
+        for (const auto& action : action_tbl[n_state]) {
+            if (action.type == Action::Type::kShift ||
+                (action.type == Action::Type::kReduce && n_reduce_prod != kNone && action.val != n_reduce_prod)) {
+                is_consistent = false;
+                break;
             }
-            for (unsigned symb : la_set.la) {
-                Action& action = action_tbl[n_state][symb];
-                if (action.val == 0) {
-                    action = {Action::Type::kReduce, pos.n_prod};
-                } else if (action.type == Action::Type::kShift) {
-                    // Shift-Reduce conflict
-                    const auto& token_info = grammar_.getTokenInfo(symb);
-                    int token_prec = token_info.prec;
-                    int prod_prec = prod.prec;
-                    if (token_prec >= 0 && prod_prec >= 0) {
-                        if (prod_prec > token_prec) {
-                            action = {Action::Type::kReduce, pos.n_prod};
-                        } else if (token_prec == prod_prec) {
-                            if (token_info.assoc == Assoc::kLeft) {
-                                action = {Action::Type::kReduce, pos.n_prod};
-                            } else if (token_info.assoc == Assoc::kNone) {
-                                action = {Action::Type::kError};
-                            }
-                        }
-                    } else {
-                        logger::warning(grammar_.getFileName())
-                            .println("shift/reduce conflict for `{}` production before `{}` look-ahead token",
-                                     get_prod_text(pos.n_prod), grammar_.symbolText(symb));
-                        ++sr_conflict_count_;
-                    }
-                } else {  // Reduce-Reduce conflict
-                    logger::warning(grammar_.getFileName())
-                        .println("reduce/reduce conflict for `{}` and `{}` productions before `{}` look-ahead token",
-                                 get_prod_text(action.val), get_prod_text(pos.n_prod), grammar_.symbolText(symb));
-                    ++rr_conflict_count_;
-                }
+            if (action.type == Action::Type::kReduce) { n_reduce_prod = action.val; }
+        }
+        if (!is_consistent || n_reduce_prod == kNone) { continue; }
+        const auto& prod = grammar_.getProductionInfo(n_reduce_prod);
+        if (prod.rhs.size() == 1 && isNonterm(prod.rhs[0]) && prod.action == 0) { unit_prods[n_state] = n_reduce_prod; }
+    }
+
+    // Goto on B from state S is replaced with goto on A from the same state, because goto state reduces
+    // `A -> B` immediately; it is repeated while goto state reduces the next unit production of the chain
+    const auto orig_goto_tbl = goto_tbl;
+    stats_.unit_reductions.clear();
+    for (unsigned n_state = 0; n_state < orig_goto_tbl.size(); ++n_state) {
+        unsigned removed_count = 0;
+        for (unsigned n = 0; n < grammar_.getNontermCount(); ++n) {
+            unsigned n_new_state = orig_goto_tbl[n_state][n], chain_length = 0;
+            while (n_new_state > 0 && unit_prods[n_new_state] != kNone && chain_length < grammar_.getNontermCount()) {
+                n_new_state = orig_goto_tbl[n_state][getIndex(grammar_.getProductionInfo(unit_prods[n_new_state]).lhs)];
+                ++chain_length;
             }
+            if (!chain_length || n_new_state == 0) { continue; }
+            goto_tbl[n_state][n] = n_new_state;
+            removed_count += chain_length;
         }
+        if (removed_count) { stats_.unit_reductions.emplace_back(n_state, removed_count); }
     }
+}
 
-    makeCompressedTables(action_tbl, goto_tbl);
+void LalrBuilder::buildSyncStates(const std::vector<std::vector<Action>>& action_tbl) {
+    for (unsigned id : grammar_.getSyncTokens()) {
+        std::vector<unsigned> states;
+        for (unsigned n_state = 0; n_state < action_tbl.size(); ++n_state) {
+            if (action_tbl[n_state][id].type == Action::Type::kShift) { states.push_back(n_state); }
+        }
+        if (states.empty()) {
+            logger::warning(grammar_.getFileName())
+                .println("synchronization token `{}` is never shifted", grammar_.symbolText(id));
+            continue;
+        }
+        sync_states_.emplace_back(id, std::move(states));
+    }
+}
+
+void LalrBuilder::buildErrorRecoveryTables(const std::vector<std::vector<Action>>& action_tbl) {
+    // Compressed tables give the same action for `$error` token: error actions can be replaced with reductions only
+    error_shift_tbl_.assign(action_tbl.size(), Action());
+    recovery_token_tbl_.assign(action_tbl.size(), ValueSet());
+    for (unsigned n_state = 0; n_state < action_tbl.size(); ++n_state) {
+        const auto& action = action_tbl[n_state][kTokenError];
+        if (action.type != Action::Type::kShift) { continue; }
+        error_shift_tbl_[n_state] = action;
+        auto& tokens = recovery_token_tbl_[action.val];
+        if (!tokens.empty()) { continue; }
+        const auto& row = action_tbl[action.val];
+        for (unsigned symb = 0; symb < row.size(); ++symb) {
+            if (row[symb].type != Action::Type::kError) { tokens.addValue(symb); }
+        }
+    }
+}
+
+void LalrBuilder::makeCombTables() {
+    packCombTable(compr_action_tbl_, grammar_.getTokenCount(), comb_action_tbl_);
+    packCombTable(compr_goto_tbl_, getStateCount(), comb_goto_tbl_);
+    logger::info(grammar_.getFileName())
+        .println(" - comb table size: action {}, goto {}", comb_action_tbl_.data.size(), comb_goto_tbl_.data.size());
 }
 
 void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& action_tbl,
                                        const std::vector<std::vector<unsigned>>& goto_tbl) {
+    // Finds the most frequent value of unsorted values: returns (value, count) pair,
+    // the least value is taken if there are several such values
+    auto find_most_frequent = [](std::vector<unsigned>& values) {
+        std::sort(values.begin(), values.end());
+        std::pair<unsigned, unsigned> most_freq{0, 0};
+        for (auto it = values.begin(); it != values.end();) {
+            auto it_next = std::find_if(it, values.end(), [v = *it](unsigned v2) { return v2 != v; });
+            if (static_cast<unsigned>(it_next - it) > most_freq.second) {
+                most_freq = std::make_pair(*it, static_cast<unsigned>(it_next - it));
+            }
+            it = it_next;
+        }
+        return most_freq;
+    };
+
     // Compress action table :
 
     std::size_t row_size_max = 0, row_size_avg = 0, row_count = 0;
+    std::vector<unsigned> shift_states, reduce_prods;
+    std::unordered_multimap<std::size_t, unsigned> row_index;  // Rows are indexed by the hash of their actions
+    row_index.reserve(action_tbl.size());
     compr_action_tbl_.index.resize(action_tbl.size());
     compr_action_tbl_.data.reserve(10000);
     for (unsigned n_state = 0; n_state < action_tbl.size(); ++n_state) {
         // Try to find the equal state
-        auto equal_it = std::find_if(action_tbl.begin(), action_tbl.begin() + n_state,
-                                     [&state = action_tbl[n_state]](const auto& state2) {
-                                         return std::equal(state2.begin(), state2.end(), state.begin());
-                                     });
-        if (equal_it != action_tbl.begin() + n_state) {
-            compr_action_tbl_.index[n_state] = compr_action_tbl_.index[equal_it - action_tbl.begin()];
+        const auto& row = action_tbl[n_state];
+        std::size_t hash = 0;
+        for (const auto& action : row) {
+            hash = hashCombine(hashCombine(hash, static_cast<unsigned>(action.type)), action.val);
+        }
+        auto [first, last] = row_index.equal_range(hash);
+        auto equal_it = std::find_if(first, last, [&action_tbl, &row](const auto& item) {
+            return std::equal(row.begin(), row.end(), action_tbl[item.second].begin());
+        });
+        if (equal_it != last) {
+            compr_action_tbl_.index[n_state] = compr_action_tbl_.index[equal_it->second];
             continue;
         }
+        row_index.emplace(hash, n_state);
 
         // If reduce action is possible for this state we can replace all
         // error actions with any of possible reduce actions.
@@ -198,14 +896,14 @@ void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& a
         // Build histograms for shift and reduce actions, count error actions as well
         unsigned error_count = 0;
         std::optional<Action> possible_reduce_action;
-        std::vector<unsigned> shift_histo(action_tbl.size(), 0);
-        std::vector<unsigned> reduce_histo(grammar_.getProductionCount(), 0);
-        for (const auto& action : action_tbl[n_state]) {
+        shift_states.clear();
+        reduce_prods.clear();
+        for (const auto& action : row) {
             switch (action.type) {
                 case Action::Type::kError: ++error_count; break;
-                case Action::Type::kShift: ++shift_histo[action.val]; break;
+                case Action::Type::kShift: shift_states.push_back(action.val); break;
                 case Action::Type::kReduce: {
-                    ++reduce_histo[action.val];
+                    reduce_prods.push_back(action.val);
                     if (!possible_reduce_action) { possible_reduce_action = action; }
                 } break;
             }
@@ -213,14 +911,14 @@ void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& a
 
         // Find the most frequent table element including all error actions if they will
         // be converted to any of reduce actions
-        auto shift_max_it = std::max_element(shift_histo.begin(), shift_histo.end());
-        Action most_freq_action{Action::Type::kShift, static_cast<unsigned>(shift_max_it - shift_histo.begin())};
+        auto [n_most_freq_state, shift_count] = find_most_frequent(shift_states);
+        Action most_freq_action{Action::Type::kShift, n_most_freq_state};
         if (possible_reduce_action) {
-            auto reduce_max_it = std::max_element(reduce_histo.begin(), reduce_histo.end());
-            if (*reduce_max_it + error_count > *shift_max_it) {
-                most_freq_action = {Action::Type::kReduce, static_cast<unsigned>(reduce_max_it - reduce_histo.begin())};
+            auto [n_most_freq_prod, reduce_count] = find_most_frequent(reduce_prods);
+            if (reduce_count + error_count > shift_count) {
+                most_freq_action = {Action::Type::kReduce, n_most_freq_prod};
             }
-        } else if (error_count > *shift_max_it) {
+        } else if (error_count > shift_count) {
             most_freq_action = {Action::Type::kError};
         }
 
@@ -228,7 +926,7 @@ void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& a
         std::size_t current_table_size = compr_action_tbl_.data.size();
         compr_action_tbl_.index[n_state] = static_cast<unsigned>(current_table_size);
         for (unsigned symb = 0; symb < grammar_.getTokenCount(); ++symb) {
-            const auto& action = action_tbl[n_state][symb];
+            const auto& action = row[symb];
             if (!possible_reduce_action || action.type != Action::Type::kError) {
                 if (action != most_freq_action) { compr_action_tbl_.data.emplace_back(symb, action); }
             } else if (most_freq_action.type == Action::Type::kShift) {
@@ -246,35 +944,66 @@ void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& a
 
     logger::info(grammar_.getFileName()).println(" - action table row size: max {}, avg {}", row_size_max, row_size_avg);
 
+    // States, which rows consist of the only default reduce action, don't need look-ahead token to make decision
+    default_reduce_tbl_.assign(action_tbl.size(), Action());
+    for (unsigned n_state = 0; n_state < action_tbl.size(); ++n_state) {
+        const auto& [symb, action] = compr_action_tbl_.data[compr_action_tbl_.index[n_state]];
+        if (symb < 0 && action.type == Action::Type::kReduce) {
+            default_reduce_tbl_[n_state] = action;
+            ++stats_.default_reduce_count;
+        }
+    }
+
     // Compress goto table :
 
     row_size_max = 0, row_size_avg = 0, row_count = 0;
+    std::vector<unsigned> new_states;
+    std::vector<std::pair<int, unsigned>> column;
+    std::unordered_multimap<std::size_t, unsigned> column_index;  // Columns are indexed by the hash of their data
+    column_index.reserve(grammar_.getNontermCount());
     compr_goto_tbl_.index.resize(grammar_.getNontermCount());
     compr_goto_tbl_.data.reserve(10000);
     for (unsigned n = 0; n < grammar_.getNontermCount(); ++n) {
         // Build histogram
-        std::vector<unsigned> histo(goto_tbl.size(), 0);
+        new_states.clear();
         for (unsigned n_state = 0; n_state < goto_tbl.size(); ++n_state) {
             unsigned n_new_state = goto_tbl[n_state][n];
-            if (n_new_state > 0) { ++histo[n_new_state]; }
+            if (n_new_state > 0) { new_states.push_back(n_new_state); }
         }
 
         // Find the most frequent state
-        auto max_it = std::max_element(histo.begin(), histo.end());
-        unsigned n_most_freq_state = static_cast<unsigned>(max_it - histo.begin());
+        const unsigned n_most_freq_state = find_most_frequent(new_states).first;
 
-        // Build compressed table
-        std::size_t current_table_size = compr_goto_tbl_.data.size();
-        compr_goto_tbl_.index[n] = static_cast<unsigned>(current_table_size);
+        // Build compressed column
+        column.clear();
         for (unsigned n_state = 0; n_state < goto_tbl.size(); ++n_state) {
             unsigned n_new_state = goto_tbl[n_state][n];
             if (n_new_state > 0 && n_new_state != n_most_freq_state) {
-                compr_goto_tbl_.data.emplace_back(static_cast<int>(n_state), n_new_state);
+                column.emplace_back(static_cast<int>(n_state), n_new_state);
             }
         }
-        compr_goto_tbl_.data.emplace_back(-1, n_most_freq_state);
+        column.emplace_back(-1, n_most_freq_state);
+
+        // Try to find the equal column
+        std::size_t hash = 0;
+        for (const auto& [n_state, n_new_state] : column) {
+            hash = hashCombine(hashCombine(hash, static_cast<unsigned>(n_state)), n_new_state);
+        }
+        auto [first, last] = column_index.equal_range(hash);
+        auto equal_it = std::find_if(first, last, [this, &column](const auto& item) {
+            return std::equal(column.begin(), column.end(), compr_goto_tbl_.data.begin() + item.second);
+        });
+        if (equal_it != last) {
+            compr_goto_tbl_.index[n] = equal_it->second;
+            continue;
+        }
+
+        std::size_t current_table_size = compr_goto_tbl_.data.size();
+        compr_goto_tbl_.index[n] = static_cast<unsigned>(current_table_size);
+        column_index.emplace(hash, static_cast<unsigned>(current_table_size));
+        compr_goto_tbl_.data.insert(compr_goto_tbl_.data.end(), column.begin(), column.end());
 
-        std::size_t row_size = compr_goto_tbl_.data.size() - current_table_size;
+        std::size_t row_size = column.size();
         row_size_max = std::max(row_size_max, row_size), row_size_avg += row_size, ++row_count;
     }
 
@@ -283,7 +1012,7 @@ void LalrBuilder::makeCompressedTables(const std::vector<std::vector<Action>>& a
     logger::info(grammar_.getFileName()).println(" - goto table row size: max {}, avg {}", row_size_max, row_size_avg);
 }
 
-ValueSet LalrBuilder::calcFirst(const std::vector<unsigned>& seq, unsigned pos) {
+ValueSet LalrBuilder::calcFirst(const std::vector<unsigned>& seq, unsigned pos) const {
     ValueSet first;
     bool is_empty_included = true;
 
@@ -309,40 +1038,73 @@ ValueSet LalrBuilder::calcFirst(const std::vector<unsigned>& seq, unsigned pos)
     return first;
 }
 
-LalrBuilder::PositionSet LalrBuilder::calcGoto(const PositionSet& s, unsigned symb) {
+/*static*/ unsigned LalrBuilder::getNextState(const std::vector<std::vector<Action>>& action_tbl,
+                                             const std::vector<std::vector<unsigned>>& goto_tbl, unsigned n_state,
+                                             unsigned symb) {
+    unsigned goto_state = 0;
+    if (isNonterm(symb)) {
+        goto_state = goto_tbl[n_state][getIndex(symb)];
+    } else if (action_tbl[n_state][symb].type == Action::Type::kShift) {
+        goto_state = action_tbl[n_state][symb].val;
+    }
+    if (goto_state == 0) { throw std::runtime_error("invalid goto state"); }
+    return goto_state;
+}
+
+unsigned LalrBuilder::findKernelItem(unsigned n_state, const Position& p) const {
+    auto first = kernel_items_.begin() + state_first_item_[n_state];
+    auto last = kernel_items_.begin() + state_first_item_[n_state + 1];
+    auto it = std::lower_bound(first, last, p);
+    if (it == last || *it != p) { throw std::runtime_error("can't find state for the next position"); }
+    return static_cast<unsigned>(it - kernel_items_.begin());
+}
+
+void LalrBuilder::calcGoto(std::span<const Position> s, unsigned symb, std::vector<Position>& s_next) const {
     ValueSet nonkern;
-    PositionSet s_next;
+    s_next.clear();
 
     // Look through source items
-    for (const auto& [pos, la_set] : s) {
+    for (const auto& pos : s) {
         const auto& prod = grammar_.getProductionInfo(pos.n_prod);
         if (pos.pos > prod.rhs.size()) {
             throw std::runtime_error("invalid position");
         } else if (pos.pos < prod.rhs.size()) {
             unsigned next_symb = prod.rhs[pos.pos];
             if (isNonterm(next_symb)) { nonkern |= Aeta_tbl_[getIndex(next_symb)]; }
-            if (next_symb == symb) { s_next.emplace(Position{pos.n_prod, pos.pos + 1}, LookAheadSet::empty_t()); }
+            if (next_symb == symb) { s_next.push_back(Position{pos.n_prod, pos.pos + 1}); }
         }
     }
 
-    // Run through nonkernel items
-    for (unsigned n_prod = 0; n_prod < grammar_.getProductionCount(); ++n_prod) {
-        const auto& prod = grammar_.getProductionInfo(n_prod);
-        assert(isNonterm(prod.lhs));
-        if (nonkern.contains(getIndex(prod.lhs)) && !prod.rhs.empty() && prod.rhs[0] == symb) {
-            s_next.emplace(Position{n_prod, 1}, LookAheadSet::empty_t());
+    if (s_next.empty() && nonkern.empty()) { return; }
+    const std::size_t kernel_item_count = s_next.size();
+
+    // Run through nonkernel items starting with `symb`
+    for (unsigned n_prod : getLeftCornerProductions(symb)) {
+        if (nonkern.contains(getIndex(grammar_.getProductionInfo(n_prod).lhs))) {
+            s_next.push_back(Position{n_prod, 1});
         }
     }
 
-    return s_next;
+    // Keep items sorted
+    if (kernel_item_count > 0 && kernel_item_count < s_next.size()) {
+        std::sort(s_next.begin(), s_next.end());
+        s_next.erase(std::unique(s_next.begin(), s_next.end()), s_next.end());
+    }
 }
 
-LalrBuilder::PositionSet LalrBuilder::calcClosure(const PositionSet& s) {
-    ValueSet nonkern;
-    std::vector<ValueSet> nonterm_la(grammar_.getNontermCount());
+void LalrBuilder::calcClosure(std::span<const Position> s, std::span<const ValueSet> s_la,
+                              ClosureBuffer& closure) const {
+    auto& nonkern = closure.nonkern;
+    auto& nonterm_la = closure.nonterm_la;
+    auto& pending = closure.pending;
+    nonterm_la.resize(grammar_.getNontermCount());
+    for (unsigned n : nonkern) { nonterm_la[n].clear(); }  // Clear the result of previous calculation
+    nonkern.clear();
+    pending.clear();
 
     // Look through kernel items
-    for (const auto& [pos, la_set] : s) {
+    for (std::size_t n_item = 0; n_item < s.size(); ++n_item) {
+        const auto& pos = s[n_item];
         const auto& prod = grammar_.getProductionInfo(pos.n_prod);
         if (pos.pos > prod.rhs.size()) {
             throw std::runtime_error("invalid position");
@@ -352,97 +1114,247 @@ LalrBuilder::PositionSet LalrBuilder::calcClosure(const PositionSet& s) {
         unsigned next_symb = prod.rhs[pos.pos];
         if (isNonterm(next_symb)) {
             // A -> alpha . B beta
-            nonkern.addValue(getIndex(next_symb));
-            ValueSet first = calcFirst(prod.rhs, pos.pos + 1);  // Calculate FIRST(beta);
-            if (first.contains(kTokenEmpty)) {
-                first.removeValue(kTokenEmpty);
-                first |= la_set.la;
+            if (!nonkern.contains(getIndex(next_symb))) {
+                nonkern.addValue(getIndex(next_symb));
+                pending.push_back(getIndex(next_symb));
             }
-            nonterm_la[getIndex(next_symb)] |= first;
+            // Add FIRST(beta) and lookahead set of the kernel item if beta =>* $empty
+            nonterm_la[getIndex(next_symb)] |= getSuffixFirst(pos.n_prod, pos.pos + 1);
+            if (isSuffixNullable(pos.n_prod, pos.pos + 1)) { nonterm_la[getIndex(next_symb)] |= s_la[n_item]; }
         }
     }
 
-    bool change = false;
-    do {
-        change = false;
-        // Run through nonkernel items
-        for (const auto& prod : grammar_.getProductions()) {
-            assert(isNonterm(prod.lhs));
-            if (nonkern.contains(getIndex(prod.lhs)) && !prod.rhs.empty() && isNonterm(prod.rhs[0])) {
-                unsigned n_right = getIndex(prod.rhs[0]);
-                // A -> . B beta
-                if (!nonkern.contains(n_right)) {
-                    nonkern.addValue(n_right);
-                    change = true;
-                }
-                ValueSet first = calcFirst(prod.rhs, 1);  // Calculate FIRST(beta);
-                if (first.contains(kTokenEmpty)) {
-                    first.removeValue(kTokenEmpty);
-                    first |= nonterm_la[getIndex(prod.lhs)];
-                }
-                ValueSet old_la = nonterm_la[n_right];
-                nonterm_la[n_right] |= first;
-                if (nonterm_la[n_right] != old_la) { change = true; }
+    // Run through nonkernel items of pending nonterminals until lookahead sets stop changing
+    ValueSet is_pending = nonkern;
+    while (!pending.empty()) {
+        unsigned n_left = pending.back();
+        pending.pop_back();
+        is_pending.removeValue(n_left);
+        for (unsigned n_prod : getNontermProductions(n_left)) {
+            const auto& prod = grammar_.getProductionInfo(n_prod);
+            if (prod.rhs.empty() || !isNonterm(prod.rhs[0])) { continue; }
+            unsigned n_right = getIndex(prod.rhs[0]);
+            // A -> . B beta
+            bool change = false;
+            if (!nonkern.contains(n_right)) {
+                nonkern.addValue(n_right);
+                change = true;
+            }
+            if (nonterm_la[n_right].orChanged(getSuffixFirst(n_prod, 1))) { change = true; }
+            if (isSuffixNullable(n_prod, 1) && nonterm_la[n_right].orChanged(nonterm_la[n_left])) { change = true; }
+            if (change && !is_pending.contains(n_right)) {
+                is_pending.addValue(n_right);
+                pending.push_back(n_right);
             }
         }
-    } while (change);
+    }
+}
 
-    auto closure = s;
+void LalrBuilder::buildItemClosures() {
+    // Collect distinct kernel items in order of their first occurrence
+    std::vector<unsigned> items;
+    item_closures_.assign(suffix_first_.size(), ItemClosure());
+    for (const auto& pos : kernel_items_) {
+        auto& item_closure = item_closures_[getItemIndex(pos)];
+        if (item_closure.is_calculated) { continue; }
+        item_closure.is_calculated = true;
+        items.push_back(getItemIndex(pos));
+    }
 
-    // Add nonkernel items
-    for (unsigned n_prod = 0; n_prod < grammar_.getProductionCount(); ++n_prod) {
-        unsigned lhs = grammar_.getProductionInfo(n_prod).lhs;
-        assert(isNonterm(lhs));
-        if (nonkern.contains(getIndex(lhs))) {  // Is production of nonkernel item
-            closure.emplace(Position{n_prod, 0}, nonterm_la[getIndex(lhs)]);
+    auto get_position = [this](unsigned n_item) {
+        auto it = std::upper_bound(prod_first_item_.begin(), prod_first_item_.end(), n_item);
+        unsigned n_prod = static_cast<unsigned>(it - prod_first_item_.begin()) - 1;
+        return Position{n_prod, n_item - prod_first_item_[n_prod]};
+    };
+
+    // Closures are calculated independently, closure data of each job is stored separately
+    struct ClosureData {
+        unsigned first = 0, last = 0;  // Range of items
+        std::vector<ClosureNonterm> nonterms;
+        std::vector<std::pair<unsigned, unsigned>> reduces;
+    };
+
+    std::vector<ClosureData> data(std::max(std::min(job_count_, static_cast<unsigned>(items.size())), 1u));
+    parallelFor(job_count_, static_cast<unsigned>(items.size()), [&](unsigned n_job, unsigned first, unsigned last) {
+        const ValueSet default_la(kTokenDefault, kTokenDefault);
+        ClosureBuffer closure;
+        auto& nonterms = data[n_job].nonterms;
+        auto& reduces = data[n_job].reduces;
+        data[n_job].first = first, data[n_job].last = last;
+        for (unsigned n = first; n < last; ++n) {
+            auto& item_closure = item_closures_[items[n]];
+            // [ B -> gamma . delta, # ]
+            const Position pos = get_position(items[n]);
+            calcClosure(std::span(&pos, 1), std::span(&default_la, 1), closure);
+            item_closure.first_nonterm = static_cast<unsigned>(nonterms.size());
+            item_closure.first_reduce = static_cast<unsigned>(reduces.size());
+            for (unsigned n_left : closure.nonkern) {
+                ValueSet& la = closure.nonterm_la[n_left];
+                bool propagate = la.contains(kTokenDefault);
+                la.removeValue(kTokenDefault);
+                if (!propagate && la.empty()) { continue; }  // Nothing to generate or propagate
+                for (unsigned n_prod : getNontermProductions(n_left)) {
+                    if (grammar_.getProductionInfo(n_prod).rhs.empty()) {
+                        reduces.emplace_back(n_prod, static_cast<unsigned>(nonterms.size()));
+                    }
+                }
+                nonterms.push_back(ClosureNonterm{n_left, propagate, la});
+            }
+            item_closure.nonterm_count = static_cast<unsigned>(nonterms.size()) - item_closure.first_nonterm;
+            item_closure.reduce_count = static_cast<unsigned>(reduces.size()) - item_closure.first_reduce;
         }
+    });
+
+    // Merge closure data
+    std::size_t nonterm_count = 0, reduce_count = 0;
+    for (const auto& job_data : data) {
+        nonterm_count += job_data.nonterms.size(), reduce_count += job_data.reduces.size();
+    }
+    closure_nonterms_.reserve(nonterm_count);
+    closure_reduces_.reserve(reduce_count);
+    for (const auto& job_data : data) {
+        const unsigned nonterm_offset = static_cast<unsigned>(closure_nonterms_.size());
+        const unsigned reduce_offset = static_cast<unsigned>(closure_reduces_.size());
+        closure_nonterms_.insert(closure_nonterms_.end(), job_data.nonterms.begin(), job_data.nonterms.end());
+        for (const auto& [n_prod, n_closure_nonterm] : job_data.reduces) {
+            closure_reduces_.emplace_back(n_prod, nonterm_offset + n_closure_nonterm);
+        }
+        for (unsigned n = job_data.first; n < job_data.last; ++n) {
+            item_closures_[items[n]].first_nonterm += nonterm_offset;
+            item_closures_[items[n]].first_reduce += reduce_offset;
+        }
+    }
+    stats_.item_closure_count += items.size();
+}
+
+void LalrBuilder::buildProductionIndex() {
+    const unsigned token_count = grammar_.getTokenCount();
+    const unsigned nonterm_count = grammar_.getNontermCount();
+    nonterm_prod_idx_.assign(nonterm_count + 1, 0);
+    left_corner_prod_idx_.assign(token_count + nonterm_count + 1, 0);
+
+    auto symbol_index = [token_count](unsigned symb) {
+        return isNonterm(symb) ? token_count + getIndex(symb) : symb;
+    };
+
+    // Count productions
+    for (const auto& prod : grammar_.getProductions()) {
+        assert(isNonterm(prod.lhs));
+        ++nonterm_prod_idx_[getIndex(prod.lhs) + 1];
+        if (!prod.rhs.empty()) { ++left_corner_prod_idx_[symbol_index(prod.rhs[0]) + 1]; }
     }
 
-    return closure;
+    // Calculate ranges and fill production lists, productions are ordered by number within each range
+    std::partial_sum(nonterm_prod_idx_.begin(), nonterm_prod_idx_.end(), nonterm_prod_idx_.begin());
+    std::partial_sum(left_corner_prod_idx_.begin(), left_corner_prod_idx_.end(), left_corner_prod_idx_.begin());
+    nonterm_prods_.resize(nonterm_prod_idx_.back());
+    left_corner_prods_.resize(left_corner_prod_idx_.back());
+    std::vector<unsigned> nonterm_fill(nonterm_prod_idx_.begin(), nonterm_prod_idx_.end() - 1);
+    std::vector<unsigned> left_corner_fill(left_corner_prod_idx_.begin(), left_corner_prod_idx_.end() - 1);
+    for (unsigned n_prod = 0; n_prod < grammar_.getProductionCount(); ++n_prod) {
+        const auto& prod = grammar_.getProductionInfo(n_prod);
+        nonterm_prods_[nonterm_fill[getIndex(prod.lhs)]++] = n_prod;
+        if (!prod.rhs.empty()) { left_corner_prods_[left_corner_fill[symbol_index(prod.rhs[0])]++] = n_prod; }
+    }
 }
 
 void LalrBuilder::buildFirstTable() {
-    first_tbl_.resize(grammar_.getNontermCount());
+    const unsigned nonterm_count = grammar_.getNontermCount();
+    first_tbl_.assign(nonterm_count, ValueSet());
 
-    bool change;
-    do {
-        change = false;
-        // Look through all productions
-        for (const auto& prod : grammar_.getProductions()) {
-            assert(isNonterm(prod.lhs));
-            unsigned n_left = getIndex(prod.lhs);
-            ValueSet first = calcFirst(prod.rhs);
-            // Append FIRST(lhs) with FIRST(rhs)
-            ValueSet old = first_tbl_[n_left];
-            first_tbl_[n_left] |= first;
-            if (first_tbl_[n_left] != old) { change = true; }
+    // FIRST(A) depends on FIRST(B) if A -> alpha B beta, where alpha consists of nonterminals
+    std::vector<std::vector<unsigned>> depends_on(nonterm_count), dependants(nonterm_count);
+    for (const auto& prod : grammar_.getProductions()) {
+        assert(isNonterm(prod.lhs));
+        for (unsigned symb : prod.rhs) {
+            if (!isNonterm(symb)) { break; }
+            depends_on[getIndex(prod.lhs)].push_back(getIndex(symb));
+            dependants[getIndex(symb)].push_back(getIndex(prod.lhs));
         }
-    } while (change);
+    }
+
+    // Strongly connected components are solved in order of dependencies, so FIRST sets of
+    // nonterminals from other components are already final. Nonterminals of the component are
+    // recalculated only while FIRST sets of their dependencies are changing
+    std::vector<unsigned> component(nonterm_count, 0), pending;
+    std::vector<bool> is_pending(nonterm_count, false);
+    unsigned n_comp = 0;
+    forEachStronglyConnectedComponent(depends_on, [&](std::span<const unsigned> scc) {
+        ++n_comp;
+        for (unsigned n : scc) { component[n] = n_comp, is_pending[n] = true; }
+        pending.assign(scc.begin(), scc.end());
+        while (!pending.empty()) {
+            unsigned n_left = pending.back();
+            pending.pop_back();
+            is_pending[n_left] = false;
+            // Append FIRST(lhs) with FIRST(rhs); it includes `$empty` if lhs is nullable
+            bool change = false;
+            for (unsigned n_prod : getNontermProductions(n_left)) {
+                if (first_tbl_[n_left].orChanged(calcFirst(grammar_.getProductionInfo(n_prod).rhs))) { change = true; }
+            }
+            if (!change) { continue; }
+            for (unsigned n : dependants[n_left]) {
+                if (component[n] == n_comp && !is_pending[n]) {
+                    is_pending[n] = true;
+                    pending.push_back(n);
+                }
+            }
+        }
+    });
 }
 
-void LalrBuilder::buildAetaTable() {
-    Aeta_tbl_.resize(grammar_.getNontermCount());
+void LalrBuilder::buildSuffixFirstTable() {
+    // FIRST(beta) is determined by its first symbol X and FIRST of the rest of the sequence if X is nullable,
+    // so suffixes with common tails share the same pool entry
+    std::unordered_map<std::uint64_t, unsigned> pool_index;
+    first_pool_.assign(1, ValueSet());  // FIRST($empty)
+    prod_first_item_.resize(grammar_.getProductionCount() + 1);
+    suffix_first_.clear();
+    for (unsigned n_prod = 0; n_prod < grammar_.getProductionCount(); ++n_prod) {
+        const auto& rhs = grammar_.getProductionInfo(n_prod).rhs;
+        const unsigned offset = static_cast<unsigned>(suffix_first_.size());
+        prod_first_item_[n_prod] = offset;
+        suffix_first_.resize(offset + rhs.size() + 1);
+        suffix_first_[offset + rhs.size()] = 1;  // Empty suffix
+        for (unsigned pos = static_cast<unsigned>(rhs.size()); pos > 0; --pos) {
+            unsigned symb = rhs[pos - 1], tail = suffix_first_[offset + pos];
+            bool is_nullable = isNonterm(symb) && first_tbl_[getIndex(symb)].contains(kTokenEmpty);
+            std::uint64_t key = (static_cast<std::uint64_t>(symb) << 32) | (is_nullable ? tail >> 1 : ~0u);
+            auto [it, success] = pool_index.emplace(key, static_cast<unsigned>(first_pool_.size()));
+            if (success) {
+                ValueSet first;
+                if (isNonterm(symb)) {
+                    first = first_tbl_[getIndex(symb)];
+                    first.removeValue(kTokenEmpty);
+                    if (is_nullable) { first |= first_pool_[tail >> 1]; }
+                } else {
+                    first.addValue(symb);
+                }
+                first_pool_.push_back(first);
+            }
+            suffix_first_[offset + pos - 1] = (it->second << 1) | (is_nullable ? tail & 1 : 0);
+        }
+    }
+    prod_first_item_.back() = static_cast<unsigned>(suffix_first_.size());
+}
 
+void LalrBuilder::buildAetaTable() {
+    // Rows of `Aeta` table form a bit matrix of left corner relation: A -> B eta
+    Aeta_tbl_.assign(grammar_.getNontermCount(), ValueSet());
     for (unsigned n = 0; n < Aeta_tbl_.size(); ++n) { Aeta_tbl_[n].addValue(n); }
+    for (const auto& prod : grammar_.getProductions()) {
+        assert(isNonterm(prod.lhs));
+        if (!prod.rhs.empty() && isNonterm(prod.rhs[0])) {
+            Aeta_tbl_[getIndex(prod.lhs)].addValue(getIndex(prod.rhs[0]));
+        }
+    }
 
-    bool change;
-    do {
-        change = false;
-        for (const auto& prod : grammar_.getProductions()) {
-            assert(isNonterm(prod.lhs));
-            if (!prod.rhs.empty()) {
-                if (isNonterm(prod.rhs[0])) {
-                    unsigned n_right = getIndex(prod.rhs[0]);
-                    for (auto& Aeta : Aeta_tbl_) {
-                        if (Aeta.contains(getIndex(prod.lhs)) && !Aeta.contains(n_right)) {
-                            Aeta.addValue(n_right);
-                            change = true;
-                        }
-                    }
-                }
-            }
+    // Warshall's transitive closure: whole rows are merged at once
+    for (unsigned k = 0; k < Aeta_tbl_.size(); ++k) {
+        for (auto& Aeta : Aeta_tbl_) {
+            if (Aeta.contains(k)) { Aeta |= Aeta_tbl_[k]; }
         }
-    } while (change);
+    }
 }
 
 void LalrBuilder::printFirstTable(uxs::iobuf& outp) {
@@ -477,13 +1389,14 @@ void LalrBuilder::printAetaTable(uxs::iobuf& outp) {
 
 void LalrBuilder::printStates(uxs::iobuf& outp) {
     uxs::println(outp, "---=== LALR analyser states : ===---").endl();
-    for (unsigned n_state = 0; n_state < states_.size(); n_state++) {
+    for (unsigned n_state = 0; n_state < getStateCount(); n_state++) {
         uxs::println(outp, "State {}:", n_state);
-        for (const auto& [pos, la_set] : states_[n_state]) {
+        for (unsigned n_item = state_first_item_[n_state]; n_item < state_first_item_[n_state + 1]; ++n_item) {
+            const auto& pos = kernel_items_[n_item];
             uxs::print(outp, "    ({}) ", pos.n_prod);
             grammar_.printProduction(outp, pos.n_prod, pos.pos);
             uxs::print(outp, " [");
-            for (unsigned symb : la_set.la) { outp.put(' ').write(grammar_.symbolText(symb)); }
+            for (unsigned symb : kernel_la_[n_item]) { outp.put(' ').write(grammar_.symbolText(symb)); }
             uxs::println(outp, " ]");
         }
         outp.endl();
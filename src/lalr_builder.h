@@ -2,7 +2,7 @@
 
 #include "grammar.h"
 
-#include <tuple>
+#include <span>
 
 // LALR table builder class
 class LalrBuilder {
@@ -15,20 +15,55 @@ class LalrBuilder {
         friend bool operator!=(const Action& a1, const Action& a2) { return !(a1 == a2); }
     };
 
+    enum class LookAheadMethod { kRelations = 0, kPropagation };
+    enum class TableFormat { kList = 0, kComb };
+
     template<typename Ty>
     struct CompressedTable {
         std::vector<unsigned> index;
         std::vector<std::pair<int, Ty>> data;
     };
 
+    // Row displacement table: the value for row `n` and column `i` is `data[base[n] + i].second` if
+    // `data[base[n] + i].first == base[n]`, otherwise it is `def[n]`
+    template<typename Ty>
+    struct CombTable {
+        std::vector<unsigned> base;
+        std::vector<Ty> def;
+        std::vector<std::pair<int, Ty>> data;
+    };
+
+    struct Statistics {
+        std::size_t state_lookups = 0;
+        std::size_t state_probes = 0;
+        std::size_t state_collisions = 0;
+        std::size_t item_closure_count = 0;
+        std::size_t default_reduce_count = 0;
+        std::vector<std::pair<unsigned, unsigned>> unit_reductions;  // (state, removed unit reduction count)
+    };
+
     explicit LalrBuilder(const Grammar& grammar) : grammar_(grammar) {}
 
+    void setLookAheadMethod(LookAheadMethod method) { lookahead_method_ = method; }
+    void setJobCount(unsigned count) { job_count_ = std::max(count, 1u); }
+    void setTableFormat(TableFormat format) { table_format_ = format; }
+    void setUnitProductionElimination(bool enable) { eliminate_unit_prods_ = enable; }
     void build();
-    unsigned getStateCount() const { return static_cast<unsigned>(states_.size()); }
+    unsigned getStateCount() const { return static_cast<unsigned>(state_first_item_.size()) - 1; }
     unsigned getSRConflictCount() const { return sr_conflict_count_; }
     unsigned getRRConflictCount() const { return rr_conflict_count_; }
     const CompressedTable<Action>& getCompressedActionTable() { return compr_action_tbl_; }
     const CompressedTable<unsigned>& getCompressedGotoTable() { return compr_goto_tbl_; }
+    const std::vector<Action>& getDefaultReduceTable() { return default_reduce_tbl_; }
+    const std::vector<Action>& getErrorShiftTable() const { return error_shift_tbl_; }
+    // Tokens, which have non-error actions in the state, for each state the analyzer comes after `$error` shift
+    const std::vector<ValueSet>& getRecoveryTokenTable() const { return recovery_token_tbl_; }
+    const CombTable<Action>& getCombActionTable() { return comb_action_tbl_; }
+    const CombTable<unsigned>& getCombGotoTable() { return comb_goto_tbl_; }
+    // (token, states) pairs: states, in which synchronization token is shifted, are entry states of the chunks of
+    // input starting with this token
+    const std::vector<std::pair<unsigned, std::vector<unsigned>>>& getSyncStates() const { return sync_states_; }
+    const Statistics& getStatistics() const { return stats_; }
     void printFirstTable(uxs::iobuf& outp);
     void printAetaTable(uxs::iobuf& outp);
     void printStates(uxs::iobuf& outp);
@@ -44,41 +79,120 @@ class LalrBuilder {
         }
     };
 
-    struct LookAheadSet {
-        struct empty_t {};
-        LookAheadSet(empty_t) {}
-        explicit LookAheadSet(unsigned id) { la.addValue(id); }
-        explicit LookAheadSet(const ValueSet& in_la) : la(in_la) {}
-        ValueSet la;
-        std::vector<const LookAheadSet*> accept_la_from;
+    // Reusable buffers for closure calculation
+    struct ClosureBuffer {
+        ValueSet nonkern;
+        std::vector<ValueSet> nonterm_la;
+        std::vector<unsigned> pending;
     };
 
-    using PositionSet = std::map<Position, LookAheadSet>;
-    template<typename... Args>
-    static PositionSet makeSinglePositionSet(const Position& p, Args&&... args) {
-        PositionSet s;
-        s.emplace(std::piecewise_construct, std::forward_as_tuple(p),
-                  std::forward_as_tuple(std::forward<Args>(args)...));
-        return s;
-    }
+    // Closure of a single kernel item with `$default` lookahead marker: nonkernel nonterminals with spontaneous
+    // lookahead sets and propagation flags, and empty nonkernel productions, which can be reduced
+    struct ItemClosure {
+        bool is_calculated = false;
+        unsigned first_nonterm = 0, nonterm_count = 0;
+        unsigned first_reduce = 0, reduce_count = 0;
+    };
+
+    struct ClosureNonterm {
+        unsigned n;
+        bool propagate;
+        ValueSet la;
+    };
 
     const Grammar& grammar_;
+    LookAheadMethod lookahead_method_ = LookAheadMethod::kRelations;
+    unsigned job_count_ = 1;
+    TableFormat table_format_ = TableFormat::kList;
+    bool eliminate_unit_prods_ = false;
 
     unsigned sr_conflict_count_ = 0;
     unsigned rr_conflict_count_ = 0;
+    Statistics stats_;
+
+    // Production numbers grouped by left part nonterminal and by the first symbol of right part
+    std::vector<unsigned> nonterm_prod_idx_;
+    std::vector<unsigned> nonterm_prods_;
+    std::vector<unsigned> left_corner_prod_idx_;
+    std::vector<unsigned> left_corner_prods_;
 
     std::vector<ValueSet> first_tbl_;
     std::vector<ValueSet> Aeta_tbl_;
 
-    std::vector<PositionSet> states_;
+    // FIRST(beta) for each `A -> alpha . beta` item: deduplicated pool of sets excluding `$empty` and
+    // `(pool index << 1) | nullable flag` for each production position, items of production are numbered
+    // starting from `prod_first_item_[n_prod]`
+    std::vector<ValueSet> first_pool_;
+    std::vector<unsigned> prod_first_item_;
+    std::vector<unsigned> suffix_first_;
+
+    // Cached closures of kernel items, indexed by item number
+    std::vector<ItemClosure> item_closures_;
+    std::vector<ClosureNonterm> closure_nonterms_;
+    std::vector<std::pair<unsigned, unsigned>> closure_reduces_;  // (production, closure nonterminal index)
+
+    // Kernel items of all states are stored contiguously and sorted within each state,
+    // lookahead sets are stored in parallel array indexed by item
+    std::vector<Position> kernel_items_;
+    std::vector<ValueSet> kernel_la_;
+    std::vector<unsigned> state_first_item_{0};
     CompressedTable<Action> compr_action_tbl_;
     CompressedTable<unsigned> compr_goto_tbl_;
+    std::vector<Action> default_reduce_tbl_;
+    std::vector<Action> error_shift_tbl_;
+    std::vector<ValueSet> recovery_token_tbl_;
+    CombTable<Action> comb_action_tbl_;
+    CombTable<unsigned> comb_goto_tbl_;
+    std::vector<std::pair<unsigned, std::vector<unsigned>>> sync_states_;
 
+    void buildStates(std::vector<std::vector<Action>>& action_tbl, std::vector<std::vector<unsigned>>& goto_tbl);
+    void buildStatesInParallel(std::vector<std::vector<Action>>& action_tbl,
+                               std::vector<std::vector<unsigned>>& goto_tbl);
+    void buildActions(std::vector<std::vector<Action>>& action_tbl);
+    void buildLookAheadsByRelations(const std::vector<std::vector<Action>>& action_tbl,
+                                    const std::vector<std::vector<unsigned>>& goto_tbl);
+    void buildLookAheadsByPropagation(const std::vector<std::vector<Action>>& action_tbl,
+                                      const std::vector<std::vector<unsigned>>& goto_tbl);
+    void eliminateUnitProductions(const std::vector<std::vector<Action>>& action_tbl,
+                                  std::vector<std::vector<unsigned>>& goto_tbl);
+    void makeCombTables();
+    void buildSyncStates(const std::vector<std::vector<Action>>& action_tbl);
+    void buildErrorRecoveryTables(const std::vector<std::vector<Action>>& action_tbl);
     void makeCompressedTables(const std::vector<std::vector<Action>>& action_tbl,
                               const std::vector<std::vector<unsigned>>& goto_tbl);
-    ValueSet calcFirst(const std::vector<unsigned>& seq, unsigned pos = 0);
-    PositionSet calcGoto(const PositionSet& s, unsigned symb);
-    PositionSet calcClosure(const PositionSet& s);
+    std::span<const Position> getKernel(unsigned n_state) const {
+        return std::span(kernel_items_.data() + state_first_item_[n_state],
+                         kernel_items_.data() + state_first_item_[n_state + 1]);
+    }
+    std::span<const ValueSet> getKernelLookAheads(unsigned n_state) const {
+        return std::span(kernel_la_.data() + state_first_item_[n_state],
+                         kernel_la_.data() + state_first_item_[n_state + 1]);
+    }
+    std::span<const unsigned> getNontermProductions(unsigned n) const {
+        return std::span(nonterm_prods_.data() + nonterm_prod_idx_[n],
+                         nonterm_prods_.data() + nonterm_prod_idx_[n + 1]);
+    }
+    std::span<const unsigned> getLeftCornerProductions(unsigned symb) const {
+        unsigned n = isNonterm(symb) ? grammar_.getTokenCount() + getIndex(symb) : symb;
+        return std::span(left_corner_prods_.data() + left_corner_prod_idx_[n],
+                         left_corner_prods_.data() + left_corner_prod_idx_[n + 1]);
+    }
+    unsigned getItemIndex(const Position& p) const { return prod_first_item_[p.n_prod] + p.pos; }
+    const ValueSet& getSuffixFirst(unsigned n_prod, unsigned pos) const {
+        return first_pool_[suffix_first_[prod_first_item_[n_prod] + pos] >> 1];
+    }
+    bool isSuffixNullable(unsigned n_prod, unsigned pos) const {
+        return suffix_first_[prod_first_item_[n_prod] + pos] & 1;
+    }
+    static unsigned getNextState(const std::vector<std::vector<Action>>& action_tbl,
+                                 const std::vector<std::vector<unsigned>>& goto_tbl, unsigned n_state, unsigned symb);
+    unsigned findKernelItem(unsigned n_state, const Position& p) const;
+    ValueSet calcFirst(const std::vector<unsigned>& seq, unsigned pos = 0) const;
+    void calcGoto(std::span<const Position> s, unsigned symb, std::vector<Position>& s_next) const;
+    void calcClosure(std::span<const Position> s, std::span<const ValueSet> s_la, ClosureBuffer& closure) const;
+    void buildItemClosures();
+    void buildProductionIndex();
     void buildFirstTable();
+    void buildSuffixFirstTable();
     void buildAetaTable();
 };
@@ -12,53 +12,53 @@ static uint8_t symb2meta[256] = {
     1, 1, 1, 1, 1
 };
 
-static int def[98] = {
+static int def[101] = {
     -1, -1, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 1, -1, -1, -1, -1, -1, -1,
     -1, -1, 0, -1, -1, 34, -1, 33, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 29, 83, 83, 83, 83,
-    83, 83, 83, 83, 83, 83, 83, 83, 83, 83
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 29, 86,
+    86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86
 };
 
-static int base[98] = {
+static int base[101] = {
     0, 39, 78, 0, 79, 0, 0, 117, 0, 83, 0, 0, 0, 0, 0, 0, 0, 148, 161, 0, 111, 0, 0, 159, 0, 0, 0, 0, 0, 174, 205, 0,
-    238, 238, 267, 178, 0, 204, 0, 0, 142, 141, 145, 145, 145, 165, 182, 187, 193, 200, 194, 0, 207, 193, 192, 0, 204,
-    204, 195, 0, 209, 212, 0, 199, 256, 252, 254, 0, 277, 290, 275, 276, 280, 292, 0, 290, 279, 0, 280, 290, 286, 288,
-    0, 298, 299, 293, 291, 291, 294, 294, 0, 293, 290, 307, 313, 296, 305, 299
+    238, 238, 267, 178, 0, 204, 0, 0, 142, 141, 145, 145, 145, 165, 183, 186, 193, 202, 195, 0, 208, 197, 208, 0, 196,
+    195, 0, 207, 207, 199, 0, 260, 263, 0, 249, 281, 277, 279, 0, 280, 293, 278, 279, 283, 295, 0, 293, 282, 0, 283,
+    293, 289, 291, 0, 301, 302, 296, 294, 294, 297, 297, 0, 296, 293, 310, 316, 299, 308, 302
 };
 
-static int next[353] = {
+static int next[356] = {
     -1, 25, 22, 26, 27, 28, 29, 30, 31, 25, 25, 32, 32, 33, 25, 25, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
     32, 32, 32, 32, 32, 32, 32, 32, 32, 34, 25, 23, 23, 5, 24, 23, 23, 23, 23, 23, 23, 23, 23, 23, 7, 23, 23, 23, 23,
     23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 3, 4, 22, 3, 3, 3, 3, 6, 3, 3,
     3, 3, 3, 20, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 8, 8, 21, 8, 8, 8, 8, 8, 9,
-    8, 8, 8, 8, 8, 8, 10, 11, 8, 8, 8, 12, 8, 8, 8, 8, 8, 8, 13, 8, 8, 14, 8, 15, 8, 16, 17, 8, 8, 8, 18, 18, 18, 78,
-    75, -1, -1, 18, 18, 18, 18, 18, 18, 19, 19, 19, -1, 68, 63, 60, 19, 19, 19, 19, 19, 19, 83, 83, 83, 83, 35, 35, 56,
-    83, 83, 83, 84, 85, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 39, 37, 37, 52, 48, 36, 49,
-    38, 50, 40, 51, 53, 54, 55, 57, 58, 59, 61, 62, 41, 64, 42, 43, 44, 45, 46, 47, -1, -1, -1, -1, -1, -1, -1, -1, 32,
+    8, 8, 8, 8, 8, 8, 10, 11, 8, 8, 8, 12, 8, 8, 8, 8, 8, 8, 13, 8, 8, 14, 8, 15, 8, 16, 17, 8, 8, 8, 18, 18, 18, 81,
+    78, -1, -1, 18, 18, 18, 18, 18, 18, 19, 19, 19, -1, 71, 66, 63, 19, 19, 19, 19, 19, 19, 86, 86, 86, 86, 35, 35, 59,
+    86, 86, 86, 87, 88, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 86, 39, 37, 37, 48, 52, 36, 49,
+    38, 53, 40, 50, 51, 56, 54, 55, 57, 58, 60, 61, 41, 62, 42, 43, 44, 45, 46, 47, -1, -1, -1, -1, -1, -1, -1, -1, 32,
     32, 37, 37, -1, -1, -1, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, -1,
-    -1, 35, 35, 65, 66, 67, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 69,
-    70, 71, 72, 73, 74, 76, 77, 79, 80, 81, 82, 83, 83, 93, 86, 91, 88, 89, 87, 90, 92, 90, 94, 95, 96, 97, 90, 83, 83,
-    83, -1, -1, -1, 83, 83, 83, 83, 83, 83, -1, -1, 83, 83, 83, 83, -1, -1
+    -1, 35, 35, 64, 65, 67, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 68,
+    69, 70, 72, 73, 74, 75, 76, 77, 79, 80, 82, 83, 84, 85, 86, 86, 96, 89, 94, 91, 92, 90, 93, 95, 93, 97, 98, 99, 100,
+    93, 86, 86, 86, -1, -1, -1, 86, 86, 86, 86, 86, 86, -1, -1, 86, 86, 86, 86, -1, -1
 };
 
-static int check[353] = {
+static int check[356] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
     1, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 9, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
     2, 7, 7, 20, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
     7, 7, 17, 17, 17, 40, 41, 23, 23, 17, 17, 17, 17, 17, 17, 18, 18, 18, 23, 42, 43, 44, 18, 18, 18, 18, 18, 18, 29,
     29, 29, 29, 35, 35, 45, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 30,
-    37, 37, 46, 47, 35, 48, 37, 49, 30, 50, 52, 53, 54, 56, 57, 58, 60, 61, 30, 63, 30, 30, 30, 30, 30, 30, 32, 32, 32,
+    37, 37, 47, 46, 35, 48, 37, 46, 30, 49, 50, 52, 53, 54, 56, 57, 59, 60, 30, 61, 30, 30, 30, 30, 30, 30, 32, 32, 32,
     32, 32, 32, 32, 32, 32, 32, 33, 33, 32, 32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
-    33, 33, 33, 33, 33, 32, 32, 34, 34, 64, 65, 66, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34,
-    34, 34, 34, 34, 34, 68, 69, 70, 71, 72, 73, 75, 76, 78, 79, 80, 81, 83, 83, 84, 85, 86, 87, 88, 85, 89, 91, 92, 93,
-    94, 95, 96, 97, 83, 83, 83, 83, 83, 84, 93, 93, 93, 93, 93, 93, 93, 93, 94, 94, 94, 94, 94, 94
+    33, 33, 33, 33, 33, 32, 32, 34, 34, 63, 64, 66, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34,
+    34, 34, 34, 34, 34, 67, 68, 69, 71, 72, 73, 74, 75, 76, 78, 79, 81, 82, 83, 84, 86, 86, 87, 88, 89, 90, 91, 88, 92,
+    94, 95, 96, 97, 98, 99, 100, 86, 86, 86, 86, 86, 87, 96, 96, 96, 96, 96, 96, 96, 96, 97, 97, 97, 97, 97, 97
 };
 
-static int accept[98] = {
-    0, 0, 0, 13, 13, 15, 14, 35, 10, 1, 3, 4, 5, 7, 6, 8, 9, 10, 2, 2, 1, 1, 16, 11, 12, 35, 32, 34, 31, 35, 35, 33, 30,
-    35, 35, 0, 27, 0, 26, 25, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 18, 0, 0, 0, 17, 0, 0, 0, 22, 0, 0, 24, 0, 0, 0, 0, 20,
-    0, 0, 0, 0, 0, 0, 23, 0, 0, 21, 0, 0, 0, 0, 19, 29, 29, 29, 29, 29, 29, 29, 28, 29, 29, 29, 29, 29, 29, 29
+static int accept[101] = {
+    0, 0, 0, 13, 13, 15, 14, 36, 10, 1, 3, 4, 5, 7, 6, 8, 9, 10, 2, 2, 1, 1, 16, 11, 12, 36, 33, 35, 32, 36, 36, 34, 31,
+    36, 36, 0, 28, 0, 27, 26, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 18, 0, 0, 0, 25, 0, 0, 17, 0, 0, 0, 22, 0, 0, 24, 0, 0,
+    0, 0, 20, 0, 0, 0, 0, 0, 0, 23, 0, 0, 21, 0, 0, 0, 0, 19, 30, 30, 30, 30, 30, 30, 30, 29, 30, 30, 30, 30, 30, 30, 30
 };
 
 static int lex(const char* first, const char* last, int** p_sptr, size_t* p_llen, int flags) {
@@ -33,6 +33,7 @@ enum {
     pat_right,
     pat_nonassoc,
     pat_prec,
+    pat_sync,
     pat_sep,
     pat_token_id,
     pat_action_id,
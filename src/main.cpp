@@ -1,19 +1,29 @@
 #include "lalr_builder.h"
 #include "parser.h"
 
+#include <parsegen/runtime.h>
+
 #include <uxs/cli/parser.h>
 #include <uxs/io/filebuf.h>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <map>
+#include <span>
+#include <stdexcept>
 
 #define XSTR(s) STR(s)
 #define STR(s)  #s
 
 template<typename Iter>
-void outputData(uxs::iobuf& outp, Iter from, Iter to, std::size_t ntab = 0) {
-    auto convert_to_string = [](const auto& v) {
+void outputData(uxs::iobuf& outp, Iter from, Iter to, std::size_t ntab = 0, bool quote_strings = true) {
+    auto convert_to_string = [quote_strings](const auto& v) {
         if constexpr (std::is_constructible<std::string, decltype(v)>::value) {
-            return '\"' + v + '\"';
+            return quote_strings ? '\"' + v + '\"' : std::string(v);
         } else {
             return uxs::to_string(v);
         }
@@ -34,68 +44,1033 @@ void outputData(uxs::iobuf& outp, Iter from, Iter to, std::size_t ntab = 0) {
     outp.write(line).put('\n');
 }
 
+int getActionCode(const LalrBuilder::Action& action) {
+    // Shift code is the new state with shift flag, reduce code is the production number
+    enum { shift_flag = 1, flag_count = 1 };
+    switch (action.type) {
+        case LalrBuilder::Action::Type::kShift: return static_cast<int>(action.val << flag_count) | shift_flag;
+        case LalrBuilder::Action::Type::kReduce: return static_cast<int>(action.val) << flag_count;
+        default: break;
+    }
+    return -1;
+}
+
 template<typename Iter>
-void outputArray(uxs::iobuf& outp, std::string_view array_name, Iter from, Iter to) {
+std::string_view getIntTypeName(Iter from, Iter to) {
+    // Chooses the smallest signed type which can hold all values
+    if (from == to) { return "int8_t"; }
+    auto [min_it, max_it] = std::minmax_element(from, to);
+    const long long min_val = *min_it, max_val = *max_it;
+    if (min_val >= INT8_MIN && max_val <= INT8_MAX) { return "int8_t"; }
+    if (min_val >= INT16_MIN && max_val <= INT16_MAX) { return "int16_t"; }
+    return "int32_t";
+}
+
+template<typename Iter>
+void outputArray(uxs::iobuf& outp, std::string_view array_name, Iter from, Iter to, std::string_view type_name = {}) {
     if (from == to) { return; }
     if constexpr (std::is_constructible<std::string_view, decltype(*from)>::value) {
-        uxs::print(outp, "\nstatic const char* ");
+        uxs::print(outp, "\nstatic const char* const ");
     } else {
-        uxs::print(outp, "\nstatic int ");
+        uxs::print(outp, "\nstatic const {} ", !type_name.empty() ? type_name : getIntTypeName(from, to));
     }
     uxs::print(outp, "{}[{}] = {{\n", array_name, std::distance(from, to));
     outputData(outp, from, to, 4);
     uxs::print(outp, "}};\n");
 }
 
-void outputParserEngine(uxs::iobuf& outp) {
+template<typename Iter>
+void outputStdArray(uxs::iobuf& outp, std::string_view array_name, Iter from, Iter to,
+                    std::string_view type_name = {}) {
+    uxs::print(outp, "\n    static constexpr std::array<{}, {}> {}{{",
+               !type_name.empty() ? type_name : getIntTypeName(from, to), std::distance(from, to), array_name);
+    if (from != to) {
+        outp.put('\n');
+        outputData(outp, from, to, 8);
+        outp.write("    ");
+    }
+    uxs::print(outp, "}};\n");
+}
+
+void makeRecoveryTokenBitmaps(const Grammar& grammar, const LalrBuilder& lr_builder, unsigned word_bits,
+                              std::vector<int>& recovery_idx, std::vector<unsigned>& recovery_tokens) {
+    // Each state the analyzer comes after `$error` shift refers to the bitmap of tokens it accepts, equal bitmaps
+    // are shared; bitmaps of `word_bits`-bit words are appended to `recovery_tokens`
+    const unsigned row_size = (grammar.getTokenCount() + word_bits - 1) / word_bits;
+    const auto& token_table = lr_builder.getRecoveryTokenTable();
+    std::map<std::vector<unsigned>, int> rows;
+    std::vector<unsigned> row(row_size);
+    recovery_idx.assign(token_table.size(), -1);
+    for (unsigned n_state = 0; n_state < token_table.size(); ++n_state) {
+        if (token_table[n_state].empty()) { continue; }
+        std::fill(row.begin(), row.end(), 0);
+        for (unsigned id : token_table[n_state]) { row[id / word_bits] |= 1u << (id % word_bits); }
+        auto [it, inserted] = rows.emplace(row, static_cast<int>(recovery_tokens.size()));
+        if (inserted) { recovery_tokens.insert(recovery_tokens.end(), row.begin(), row.end()); }
+        recovery_idx[n_state] = it->second;
+    }
+    if (recovery_tokens.empty()) { recovery_tokens.push_back(0); }  // The array must not be empty
+}
+
+struct ReduceInfo {
+    unsigned length;
+    unsigned goto_idx;
+    unsigned action;
+};
+
+void outputReduceInfo(uxs::iobuf& outp, const std::vector<ReduceInfo>& reduce_info, bool cpp) {
+    // One record per production: length, goto row or index, and action on reduce
+    if (reduce_info.empty() && !cpp) { return; }
+    auto field_type = [&reduce_info](unsigned ReduceInfo::*field) {
+        std::vector<unsigned> values(reduce_info.size());
+        std::transform(reduce_info.begin(), reduce_info.end(), values.begin(),
+                       [field](const ReduceInfo& info) { return info.*field; });
+        return getIntTypeName(values.begin(), values.end());
+    };
+    std::string_view tab = cpp ? "    " : "";
+    uxs::print(outp, cpp ? "\n    struct reduce_record {{\n" : "\nstatic const struct {{\n");
+    uxs::print(outp, "{}    {} length;\n", tab, field_type(&ReduceInfo::length));
+    uxs::print(outp, "{}    {} goto_idx;\n", tab, field_type(&ReduceInfo::goto_idx));
+    uxs::print(outp, "{}    {} action;\n", tab, field_type(&ReduceInfo::action));
+    if (cpp) {
+        uxs::print(outp, "    }};\n");
+        uxs::print(outp, "    static constexpr std::array<reduce_record, {}> reduce_info{{{{\n", reduce_info.size());
+    } else {
+        uxs::print(outp, "}} reduce_info[{}] = {{\n", reduce_info.size());
+    }
+    std::vector<std::string> records(reduce_info.size());
+    std::transform(reduce_info.begin(), reduce_info.end(), records.begin(), [](const ReduceInfo& info) {
+        return uxs::format("{{{}, {}, {}}}", info.length, info.goto_idx, info.action);
+    });
+    outputData(outp, records.begin(), records.end(), tab.size() + 4, false);
+    uxs::print(outp, cpp ? "    }}}};\n" : "}};\n");
+}
+
+void outputCppPrologue(uxs::iobuf& outp) {
     // clang-format off
     static constexpr std::string_view text[] = {
-        "static int parse(int tt, int* sptr0, int** p_sptr, int rise_error) {",
+        "template<typename Ty, std::size_t N>",
+        "constexpr const Ty& table_at(const std::array<Ty, N>& tbl, int i) {",
+        "#if defined(PARSEGEN_TABLE_CHECKS)",
+        "    if (i < 0 || static_cast<std::size_t>(i) >= N) { std::abort(); }",
+        "#endif",
+        "    return tbl[i];",
+        "}",
+    };
+    // clang-format on
+    outp.put('\n');
+    for (const auto& l : text) { outp.write(l).put('\n'); }
+}
+
+struct EngineSyntax {
+    std::string_view inline_func_prefix;  // Replaces `static inline ` of function definitions
+    std::string_view func_prefix;         // Replaces `static ` of function definitions
+    std::string_view table_prefix;        // Table access `name[i]` is output as `<prefix>name<open>i<close>`
+    std::string_view index_open;
+    std::string_view index_close;
+};
+
+const EngineSyntax kCEngineSyntax{"static inline ", "static ", "", "[", "]"};
+const EngineSyntax kCppEngineSyntax{"template<typename Tables = parser_tables>\nconstexpr ",
+                                    "template<typename Tables = parser_tables>\nconstexpr ", "table_at(Tables::", ", ",
+                                    ")"};
+
+std::string rewriteTableAccess(std::string_view text, const EngineSyntax& syntax) {
+    // Each identifier followed by `[` in the engine text is a table
+    auto is_id_char = [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_'; };
+    std::string result;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        if (!is_id_char(text[pos])) {
+            result += text[pos++];
+            continue;
+        }
+        std::size_t id_end = pos;
+        while (id_end < text.size() && is_id_char(text[id_end])) { ++id_end; }
+        if (id_end == text.size() || text[id_end] != '[' || std::isdigit(static_cast<unsigned char>(text[pos]))) {
+            result.append(text.substr(pos, id_end - pos));
+            pos = id_end;
+            continue;
+        }
+        std::size_t index_end = id_end + 1;
+        for (unsigned depth = 1; index_end < text.size(); ++index_end) {
+            if (text[index_end] == '[') {
+                ++depth;
+            } else if (text[index_end] == ']' && --depth == 0) {
+                break;
+            }
+        }
+        if (index_end == text.size()) { throw std::runtime_error("unbalanced brackets in analyzer engine text"); }
+        result.append(syntax.table_prefix).append(text.substr(pos, id_end - pos)).append(syntax.index_open);
+        result += rewriteTableAccess(text.substr(id_end + 1, index_end - id_end - 1), syntax);
+        result.append(syntax.index_close);
+        pos = index_end + 1;
+    }
+    return result;
+}
+
+std::string forwardTablesParameter(std::string_view text) {
+    // Calls of analyzer functions are output as `name<Tables>(...)`
+    static constexpr std::string_view kAnalyzerFuncs[] = {"parse", "parse_step", "need_lookahead"};
+    auto is_id_char = [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_'; };
+    std::string result;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        if (!is_id_char(text[pos])) {
+            result += text[pos++];
+            continue;
+        }
+        std::size_t id_end = pos;
+        while (id_end < text.size() && is_id_char(text[id_end])) { ++id_end; }
+        const std::string_view id = text.substr(pos, id_end - pos);
+        result.append(id);
+        if (id_end < text.size() && text[id_end] == '(' &&
+            std::find(std::begin(kAnalyzerFuncs), std::end(kAnalyzerFuncs), id) != std::end(kAnalyzerFuncs)) {
+            result.append("<Tables>");
+        }
+        pos = id_end;
+    }
+    return result;
+}
+
+void outputEngineLine(uxs::iobuf& outp, std::string_view l, const EngineSyntax& syntax) {
+    if (l.starts_with("static inline ")) {
+        outp.write(syntax.inline_func_prefix);
+        l.remove_prefix(std::string_view("static inline ").size());
+    } else if (l.starts_with("static ")) {
+        outp.write(syntax.func_prefix);
+        l.remove_prefix(std::string_view("static ").size());
+    }
+    outp.write(rewriteTableAccess(l, syntax)).put('\n');
+}
+
+void outputTableParserEngine(uxs::iobuf& outp, LalrBuilder::TableFormat table_format, const EngineSyntax& syntax) {
+    // The engine text is written in C once for all table formats and output languages
+    // clang-format off
+    static constexpr std::string_view head_text[] = {
+        "static inline int need_lookahead(const parser_state_t* sptr) { return default_reduce[*(sptr - 1)] < 0; }",
+        "",
+        "static inline int is_recovery_token(const parser_state_t* sptr, int tt) {",
+        "    int i = recovery_idx[*(sptr - 1)];",
+        "    return i < 0 || (recovery_tokens[i + (tt >> 3)] & (1 << (tt & 7))) != 0;",
+        "}",
+        "",
+        "static int parse(int tt, parser_state_t* sptr0, parser_state_t** p_sptr, int rise_error) {",
         "    enum { shift_flag = 1, flag_count = 1 };",
+        "    parser_state_t* sptr = *p_sptr;",
         "    int action = rise_error;",
-        "    if (action >= 0) {",
-        "        const int* action_tbl = &action_list[action_idx[*(*p_sptr - 1)]];",
-        "        while (action_tbl[0] >= 0 && action_tbl[0] != tt) { action_tbl += 2; }",
-        "        action = action_tbl[1];",
+        "    if (action >= 0 && (action = default_reduce[*(sptr - 1)]) < 0) {",
+    };
+    static constexpr std::string_view list_action_text[] = {
+        "        int i = action_idx[*(sptr - 1)];",
+        "        while (action_list[i] >= 0 && action_list[i] != tt) { i += 2; }",
+        "        action = action_list[i + 1];",
+    };
+    static constexpr std::string_view comb_action_text[] = {
+        "        int state = *(sptr - 1), base = action_base[state], l = base + tt;",
+        "        action = action_def[state];",
+        "        if (action_check[l] == base) { action = action_next[l]; }",
+    };
+    static constexpr std::string_view reduce_text[] = {
         "    }",
         "    if (action >= 0) {",
         "        if (!(action & shift_flag)) {",
-        "            const int* info = &reduce_info[action >> flag_count];",
-        "            const int* goto_tbl = &goto_list[info[1]];",
-        "            int state = *((*p_sptr -= info[0]) - 1);",
-        "            while (goto_tbl[0] >= 0 && goto_tbl[0] != state) { goto_tbl += 2; }",
-        "            *(*p_sptr)++ = goto_tbl[1];",
-        "            return predef_act_reduce + info[2];",
+        "            int n_prod = action >> flag_count, i = reduce_info[n_prod].goto_idx;",
+        "            int state = *((sptr -= reduce_info[n_prod].length) - 1);",
+    };
+    static constexpr std::string_view list_goto_text[] = {
+        "            while (goto_list[i] >= 0 && goto_list[i] != state) { i += 2; }",
+        "            *sptr++ = goto_list[i + 1];",
+    };
+    static constexpr std::string_view comb_goto_text[] = {
+        "            int base = goto_base[i], l = base + state, new_state = goto_def[i];",
+        "            if (goto_check[l] == base) { new_state = goto_next[l]; }",
+        "            *sptr++ = new_state;",
+    };
+    static constexpr std::string_view tail_text[] = {
+        "            *p_sptr = sptr;",
+        "            return predef_act_reduce + reduce_info[n_prod].action;",
         "        }",
-        "        *(*p_sptr)++ = action >> flag_count;",
+        "        *sptr++ = action >> flag_count;",
+        "        *p_sptr = sptr;",
         "        return predef_act_shift;",
         "    }",
         "    /* Roll back to state, which can accept error */",
         "    do {",
-        "        const int* action_tbl = &action_list[action_idx[*(*p_sptr - 1)]];",
-        "        while (action_tbl[0] >= 0 && action_tbl[0] != predef_tt_error) { action_tbl += 2; }",
-        "        if (action_tbl[1] >= 0 && (action_tbl[1] & shift_flag)) { /* Can recover */",
-        "            *(*p_sptr)++ = action_tbl[1] >> flag_count;           /* Shift error token */",
+        "        int state = error_shift[*(sptr - 1)];",
+        "        if (state >= 0) {    /* Can recover */",
+        "            *sptr++ = state; /* Shift error token */",
         "            break;",
         "        }",
-        "    } while (--*p_sptr != sptr0);",
+        "    } while (--sptr != sptr0);",
+        "    *p_sptr = sptr;",
         "    return action;",
         "}",
+        "",
+        "/* One step of `parse()` without error recovery for loops keeping the stack pointer in a local: returns",
+        "   the new stack pointer and stores the action identifier or the error code to `*p_action` */",
+        "static inline parser_state_t* parse_step(int tt, parser_state_t* sptr, int* p_action) {",
+        "    enum { shift_flag = 1, flag_count = 1 };",
+        "    int action = default_reduce[*(sptr - 1)];",
+        "    if (action < 0) {",
+    };
+    static constexpr std::string_view step_tail_text[] = {
+        "            *p_action = predef_act_reduce + reduce_info[n_prod].action;",
+        "            return sptr;",
+        "        }",
+        "        *sptr++ = action >> flag_count;",
+        "        action = predef_act_shift;",
+        "    }",
+        "    *p_action = action;",
+        "    return sptr;",
+        "}",
     };
     // clang-format on
+    const bool comb = table_format == LalrBuilder::TableFormat::kComb;
+    const auto action_text = comb ? std::span<const std::string_view>(comb_action_text) : list_action_text;
+    const auto goto_text = comb ? std::span<const std::string_view>(comb_goto_text) : list_goto_text;
+    // The step is made of the same action and goto texts as `parse()`
+    const std::span<const std::string_view> parts[] = {
+        head_text, action_text, reduce_text, goto_text, tail_text, action_text, reduce_text, goto_text, step_tail_text,
+    };
     outp.put('\n');
-    for (const auto& l : text) { outp.write(l).put('\n'); }
+    for (const auto& part : parts) {
+        for (std::string_view l : part) { outputEngineLine(outp, l, syntax); }
+    }
+}
+
+void outputParserSession(uxs::iobuf& outp, bool cpp) {
+    // clang-format off
+    static constexpr std::string_view text[] = {
+        "enum { parser_session_inline_size = 64, parser_session_nomem = -2 };",
+        "",
+        "/* Allocates memory for the state stack like `realloc()`, frees `p` if `size` is 0 */",
+        "typedef void* (*parser_realloc_func)(void* ctx, void* p, size_t size);",
+        "",
+        "static inline void* parser_default_realloc(void* ctx, void* p, size_t size) {",
+        "    (void)ctx;",
+        "    if (!size) {",
+        "        free(p);",
+        "        return 0;",
+        "    }",
+        "    return realloc(p, size);",
+        "}",
+        "",
+        "/* Owns the state stack: the initial buffer is used until the stack grows, then it is moved to the memory",
+        "   of `realloc_func`, so sessions can be served from a pool or an arena of the caller */",
+        "struct parser_session {",
+        "    parser_state_t* stack;",
+        "    parser_state_t* sptr;",
+        "    parser_state_t* slast;",
+        "    int keep; /* States below this depth are unchanged since the last checkpoint */",
+        "    parser_state_t* buffer;",
+        "    int buffer_size;",
+        "    parser_realloc_func realloc_func;",
+        "    void* alloc_ctx;",
+        "    parser_state_t inline_stack[parser_session_inline_size];",
+        "};",
+        "",
+        "/* Uses `buffer` of `buffer_size` > 0 states or the inline one if `buffer` is null, and memory of",
+        "   `realloc_func` called with `ctx` or `realloc()` if `realloc_func` is null */",
+        "static inline void parser_session_init_ex(struct parser_session* s, int sc, parser_state_t* buffer,",
+        "                                         int buffer_size, parser_realloc_func realloc_func, void* ctx) {",
+        "    if (!buffer) { buffer = s->inline_stack, buffer_size = parser_session_inline_size; }",
+        "    s->buffer = buffer, s->buffer_size = buffer_size;",
+        "    s->realloc_func = realloc_func ? realloc_func : parser_default_realloc, s->alloc_ctx = ctx;",
+        "    s->stack = buffer, s->slast = buffer + buffer_size;",
+        "    s->sptr = s->stack, *s->sptr++ = (parser_state_t)sc, s->keep = 0;",
+        "}",
+        "",
+        "static inline void parser_session_init(struct parser_session* s, int sc) {",
+        "    parser_session_init_ex(s, sc, 0, 0, 0, 0);",
+        "}",
+        "",
+        "static inline void parser_session_reset(struct parser_session* s, int sc) {",
+        "    s->sptr = s->stack, *s->sptr++ = (parser_state_t)sc, s->keep = 0;",
+        "}",
+        "",
+        "static inline void parser_session_free(struct parser_session* s) {",
+        "    if (s->stack != s->buffer) { s->realloc_func(s->alloc_ctx, s->stack, 0); }",
+        "    s->stack = s->sptr = s->buffer, s->slast = s->buffer + s->buffer_size;",
+        "    s->keep = 0;",
+        "}",
+        "",
+        "static inline int parser_session_grow(struct parser_session* s) {",
+        "    size_t size = (size_t)(s->slast - s->stack), count = (size_t)(s->sptr - s->stack);",
+        "    parser_state_t* stack = (parser_state_t*)s->realloc_func(",
+        "        s->alloc_ctx, s->stack != s->buffer ? s->stack : 0, 2 * size * sizeof(parser_state_t));",
+        "    if (!stack) { return 0; }",
+        "    if (s->stack == s->buffer) { memcpy(stack, s->stack, count * sizeof(parser_state_t)); }",
+        "    s->stack = stack, s->sptr = stack + count, s->slast = stack + 2 * size;",
+        "    return 1;",
+        "}",
+        "",
+        "/* The state under the top is replaced by reductions and error recovery, the states below it are kept */",
+        "static inline void parser_session_update_keep(struct parser_session* s) {",
+        "    int depth = (int)(s->sptr - s->stack);",
+        "    if (depth <= s->keep) { s->keep = depth > 0 ? depth - 1 : 0; }",
+        "}",
+        "",
+        "static inline int parser_session_need_lookahead(const struct parser_session* s) {",
+        "    return need_lookahead(s->sptr);",
+        "}",
+        "",
+        "static inline int parser_session_push_token(struct parser_session* s, int tt, int rise_error) {",
+        "    int action;",
+        "    if (s->sptr == s->slast && !parser_session_grow(s)) { return parser_session_nomem; }",
+        "    action = parse(tt, s->stack, &s->sptr, rise_error);",
+        "    parser_session_update_keep(s);",
+        "    return action;",
+        "}",
+        "",
+        "struct parser_reduction {",
+        "    int action;   /* Action identifier returned by `parse()` */",
+        "    int length;   /* Reduction length */",
+        "    int tt_index; /* Index of the look-ahead token */",
+        "};",
+        "",
+        "/* Parses tokens until the input runs out, the output is full or an error occurs: the loop is made of",
+        "   `parse()` steps and keeps the stack pointer and the kept depth in locals, errors go through `parse()` */",
+        "static inline int parser_session_parse_batch(struct parser_session* s, const int* tt_first,",
+        "                                             const int* tt_last, const int** p_tt,",
+        "                                             struct parser_reduction* rd_last,",
+        "                                             struct parser_reduction** p_rd) {",
+        "    const int* tt = *p_tt;",
+        "    struct parser_reduction* rd = *p_rd;",
+        "    parser_state_t *stack, *sptr, *slast;",
+        "    int keep, result = 0;",
+        "    if (s->sptr == s->slast && !parser_session_grow(s)) { return parser_session_nomem; }",
+        "    stack = s->stack, sptr = s->sptr, slast = s->slast, keep = s->keep;",
+        "    while (tt != tt_last && rd != rd_last) {",
+        "        int action;",
+        "        parser_state_t* sptr_next = parse_step(*tt, sptr, &action);",
+        "        if (action < 0) {",
+        "            s->sptr = sptr;",
+        "            result = parse(*tt, stack, &s->sptr, 0);",
+        "            sptr = s->sptr;",
+        "            if ((int)(sptr - stack) <= keep) { keep = sptr != stack ? (int)(sptr - stack) - 1 : 0; }",
+        "            break;",
+        "        }",
+        "        if (action != predef_act_shift) {",
+        "            rd->action = action, rd->length = (int)(sptr - sptr_next) + 1;",
+        "            rd->tt_index = (int)(tt - tt_first), ++rd;",
+        "            sptr = sptr_next;",
+        "            if ((int)(sptr - stack) <= keep) { keep = (int)(sptr - stack) - 1; }",
+        "            if (sptr != slast) { continue; } /* Only an empty production grows the stack */",
+        "        } else {",
+        "            sptr = sptr_next, ++tt;",
+        "            if (sptr != slast) { continue; }",
+        "        }",
+        "        /* There is at least one free entry before each step */",
+        "        s->sptr = sptr;",
+        "        if (!parser_session_grow(s)) {",
+        "            result = parser_session_nomem;",
+        "            break;",
+        "        }",
+        "        stack = s->stack, sptr = s->sptr, slast = s->slast;",
+        "    }",
+        "    s->sptr = sptr, s->keep = keep;",
+        "    *p_tt = tt, *p_rd = rd;",
+        "    return result;",
+        "}",
+        "",
+        "struct parser_stack_node {",
+        "    int state;",
+        "    int depth;  /* Stack depth with this state */",
+        "    int parent; /* Node of the state below or -1 */",
+        "};",
+        "",
+        "struct parser_checkpoint {",
+        "    int tt_index; /* Index of the next token, checkpoints after the gap are shifted by `delta` */",
+        "    int node;     /* Node of the top state */",
+        "};",
+        "",
+        "/* State stacks saved at token boundaries to restart parsing after an edit: stacks share the nodes of equal",
+        "   bottom parts, and checkpoints are kept in a gap buffer, so an edit doesn't copy checkpoints after it */",
+        "struct parser_checkpoints {",
+        "    struct parser_stack_node* nodes;",
+        "    struct parser_checkpoint* items; /* Checkpoints are in [0, gap) and [gap_end, capacity) */",
+        "    int node_count, node_capacity;",
+        "    int gap, gap_end, capacity;",
+        "    int delta;",
+        "    parser_realloc_func realloc_func;",
+        "    void* alloc_ctx;",
+        "};",
+        "",
+        "static inline void parser_checkpoints_clear(struct parser_checkpoints* cp) {",
+        "    cp->nodes = 0, cp->items = 0;",
+        "    cp->node_count = cp->node_capacity = 0;",
+        "    cp->gap = cp->gap_end = cp->capacity = cp->delta = 0;",
+        "}",
+        "",
+        "/* Uses memory of `realloc_func` called with `ctx` or `realloc()` if `realloc_func` is null */",
+        "static inline void parser_checkpoints_init_ex(struct parser_checkpoints* cp,",
+        "                                             parser_realloc_func realloc_func, void* ctx) {",
+        "    parser_checkpoints_clear(cp);",
+        "    cp->realloc_func = realloc_func ? realloc_func : parser_default_realloc, cp->alloc_ctx = ctx;",
+        "}",
+        "",
+        "static inline void parser_checkpoints_init(struct parser_checkpoints* cp) {",
+        "    parser_checkpoints_init_ex(cp, 0, 0);",
+        "}",
+        "",
+        "static inline void parser_checkpoints_free(struct parser_checkpoints* cp) {",
+        "    if (cp->nodes) { cp->realloc_func(cp->alloc_ctx, cp->nodes, 0); }",
+        "    if (cp->items) { cp->realloc_func(cp->alloc_ctx, cp->items, 0); }",
+        "    parser_checkpoints_clear(cp);",
+        "}",
+        "",
+        "static inline int parser_checkpoints_count(const struct parser_checkpoints* cp) {",
+        "    return cp->gap + cp->capacity - cp->gap_end;",
+        "}",
+        "",
+        "static inline int parser_checkpoints_tt_index(const struct parser_checkpoints* cp, int n) {",
+        "    return n < cp->gap ? cp->items[n].tt_index : cp->items[n + cp->gap_end - cp->gap].tt_index + cp->delta;",
+        "}",
+        "",
+        "/* Moves the gap after the first `n` checkpoints */",
+        "static inline void parser_checkpoints_move_gap(struct parser_checkpoints* cp, int n) {",
+        "    while (cp->gap > n) {",
+        "        cp->items[--cp->gap_end] = cp->items[--cp->gap];",
+        "        cp->items[cp->gap_end].tt_index -= cp->delta;",
+        "    }",
+        "    while (cp->gap < n) {",
+        "        cp->items[cp->gap] = cp->items[cp->gap_end++];",
+        "        cp->items[cp->gap++].tt_index += cp->delta;",
+        "    }",
+        "}",
+        "",
+        "/* Removes nodes of dropped checkpoints, parent nodes always precede their children */",
+        "static inline void parser_checkpoints_compact(struct parser_checkpoints* cp, int* new_index) {",
+        "    int n, node, count = 0, shift = cp->gap_end - cp->gap;",
+        "    for (n = 0; n < cp->node_count; ++n) { new_index[n] = -1; }",
+        "    for (n = 0; n < parser_checkpoints_count(cp); ++n) {",
+        "        node = cp->items[n < cp->gap ? n : n + shift].node;",
+        "        for (; node >= 0 && new_index[node] < 0; node = cp->nodes[node].parent) {",
+        "            new_index[node] = 0;",
+        "        }",
+        "    }",
+        "    for (n = 0; n < cp->node_count; ++n) {",
+        "        if (new_index[n] < 0) { continue; }",
+        "        node = cp->nodes[n].parent, cp->nodes[count] = cp->nodes[n];",
+        "        cp->nodes[count].parent = node >= 0 ? new_index[node] : -1, new_index[n] = count++;",
+        "    }",
+        "    for (n = 0; n < parser_checkpoints_count(cp); ++n) {",
+        "        struct parser_checkpoint* item = &cp->items[n < cp->gap ? n : n + shift];",
+        "        item->node = new_index[item->node];",
+        "    }",
+        "    cp->node_count = count;",
+        "}",
+        "",
+        "static inline int parser_checkpoints_reserve(struct parser_checkpoints* cp, int node_count) {",
+        "    if (cp->node_count + node_count > cp->node_capacity) {",
+        "        size_t size = (size_t)cp->node_count * sizeof(int);",
+        "        int* new_index = size ? (int*)cp->realloc_func(cp->alloc_ctx, 0, size) : 0;",
+        "        if (new_index) {",
+        "            parser_checkpoints_compact(cp, new_index);",
+        "            cp->realloc_func(cp->alloc_ctx, new_index, 0);",
+        "        }",
+        "    }",
+        "    if (2 * (cp->node_count + node_count) > cp->node_capacity) {",
+        "        /* At least a half of nodes is free after growing or compaction */",
+        "        int capacity = 2 * (cp->node_count + node_count);",
+        "        struct parser_stack_node* nodes;",
+        "        if (capacity < 2 * cp->node_capacity) { capacity = 2 * cp->node_capacity; }",
+        "        nodes = (struct parser_stack_node*)cp->realloc_func(",
+        "            cp->alloc_ctx, cp->nodes, (size_t)capacity * sizeof(struct parser_stack_node));",
+        "        if (!nodes) { return 0; }",
+        "        cp->nodes = nodes, cp->node_capacity = capacity;",
+        "    }",
+        "    if (cp->gap == cp->gap_end) {",
+        "        int capacity = cp->capacity ? 2 * cp->capacity : 16, tail = cp->capacity - cp->gap_end;",
+        "        struct parser_checkpoint* items = (struct parser_checkpoint*)cp->realloc_func(",
+        "            cp->alloc_ctx, cp->items, (size_t)capacity * sizeof(struct parser_checkpoint));",
+        "        if (!items) { return 0; }",
+        "        memmove(items + capacity - tail, items + cp->gap_end,",
+        "                (size_t)tail * sizeof(struct parser_checkpoint));",
+        "        cp->items = items, cp->gap_end = capacity - tail, cp->capacity = capacity;",
+        "    }",
+        "    return 1;",
+        "}",
+        "",
+        "/* Saves the state stack before token `tt_index` into the gap; the stack shares its unchanged bottom part",
+        "   with the checkpoint before the gap, which must be the last one added or restored with this session */",
+        "static inline int parser_checkpoints_add(struct parser_checkpoints* cp, struct parser_session* s,",
+        "                                         int tt_index) {",
+        "    int depth = (int)(s->sptr - s->stack), keep = cp->gap ? s->keep : 0, node;",
+        "    if (!parser_checkpoints_reserve(cp, depth - keep)) { return parser_session_nomem; }",
+        "    node = cp->gap ? cp->items[cp->gap - 1].node : -1;",
+        "    while (node >= 0 && cp->nodes[node].depth > keep) { node = cp->nodes[node].parent; }",
+        "    for (; keep < depth; ++keep) {",
+        "        struct parser_stack_node* new_node = &cp->nodes[cp->node_count];",
+        "        new_node->state = s->stack[keep], new_node->depth = keep + 1, new_node->parent = node;",
+        "        node = cp->node_count++;",
+        "    }",
+        "    cp->items[cp->gap].tt_index = tt_index, cp->items[cp->gap++].node = node;",
+        "    s->keep = depth;",
+        "    return 0;",
+        "}",
+        "",
+        "/* Returns the last checkpoint not after token `tt_index` or -1 */",
+        "static inline int parser_checkpoints_find(const struct parser_checkpoints* cp, int tt_index) {",
+        "    int first = 0, last = parser_checkpoints_count(cp);",
+        "    while (first < last) {",
+        "        int mid = (first + last) / 2;",
+        "        if (parser_checkpoints_tt_index(cp, mid) <= tt_index) {",
+        "            first = mid + 1;",
+        "        } else {",
+        "            last = mid;",
+        "        }",
+        "    }",
+        "    return first - 1;",
+        "}",
+        "",
+        "/* Prepares checkpoints for replacing `old_count` tokens starting from `tt_index` with `new_count`",
+        "   ones: drops checkpoints inside the edit and shifts ones after it, returns the checkpoint to restart",
+        "   parsing from or -1 */",
+        "static inline int parser_checkpoints_edit(struct parser_checkpoints* cp, int tt_index, int old_count,",
+        "                                          int new_count) {",
+        "    int n = parser_checkpoints_find(cp, tt_index);",
+        "    parser_checkpoints_move_gap(cp, n + 1);",
+        "    tt_index += old_count;",
+        "    while (cp->gap_end < cp->capacity && cp->items[cp->gap_end].tt_index + cp->delta < tt_index) {",
+        "        ++cp->gap_end;",
+        "    }",
+        "    cp->delta += new_count - old_count;",
+        "    return n;",
+        "}",
+        "",
+        "/* Restores the state stack of checkpoint `n`, parsing continues from its token */",
+        "static inline int parser_checkpoints_restore(struct parser_checkpoints* cp, int n,",
+        "                                             struct parser_session* s) {",
+        "    int node, depth;",
+        "    parser_checkpoints_move_gap(cp, n + 1);",
+        "    node = cp->items[n].node, depth = cp->nodes[node].depth;",
+        "    while (s->slast - s->stack <= depth) {",
+        "        if (!parser_session_grow(s)) { return parser_session_nomem; }",
+        "    }",
+        "    s->sptr = s->stack + depth, s->keep = depth;",
+        "    for (; node >= 0; node = cp->nodes[node].parent) {",
+        "        s->stack[--depth] = (parser_state_t)cp->nodes[node].state;",
+        "    }",
+        "    return 0;",
+        "}",
+        "",
+        "/* Drops checkpoints after the gap, e.g. if parsing is stopped before the end of input */",
+        "static inline void parser_checkpoints_truncate(struct parser_checkpoints* cp) { cp->gap_end = cp->capacity; }",
+        "",
+        "/* Compares the state stack with the one of `node` down to the part shared with the last checkpoint */",
+        "static inline int parser_checkpoints_same_stack(const struct parser_checkpoints* cp, int node,",
+        "                                                const struct parser_session* s) {",
+        "    int depth = (int)(s->sptr - s->stack), keep = cp->gap ? s->keep : 0;",
+        "    int base = cp->gap ? cp->items[cp->gap - 1].node : -1;",
+        "    if (cp->nodes[node].depth != depth) { return 0; }",
+        "    for (; depth > keep; node = cp->nodes[node].parent) {",
+        "        if (cp->nodes[node].state != s->stack[--depth]) { return 0; }",
+        "    }",
+        "    while (base >= 0 && cp->nodes[base].depth > depth) { base = cp->nodes[base].parent; }",
+        "    for (; node != base; node = cp->nodes[node].parent, base = cp->nodes[base].parent) {",
+        "        if (cp->nodes[node].state != cp->nodes[base].state) { return 0; }",
+        "    }",
+        "    return 1;",
+        "}",
+        "",
+        "/* Checks if the state stack before token `tt_index` is the same as of the checkpoint after the gap at",
+        "   this token, so the rest of parsing will be the same; checkpoints after the gap before `tt_index` and",
+        "   a mismatched one are dropped */",
+        "static inline int parser_checkpoints_match(struct parser_checkpoints* cp, const struct parser_session* s,",
+        "                                           int tt_index) {",
+        "    while (cp->gap_end < cp->capacity && cp->items[cp->gap_end].tt_index + cp->delta < tt_index) {",
+        "        ++cp->gap_end;",
+        "    }",
+        "    if (cp->gap_end == cp->capacity || cp->items[cp->gap_end].tt_index + cp->delta != tt_index) { return 0; }",
+        "    if (!parser_checkpoints_same_stack(cp, cp->items[cp->gap_end].node, s)) {",
+        "        ++cp->gap_end;",
+        "        return 0;",
+        "    }",
+        "    return 1;",
+        "}",
+    };
+    // clang-format on
+    outp.put('\n');
+    if (!cpp) {
+        for (const auto& l : text) { outp.write(l).put('\n'); }
+        return;
+    }
+    // In C++ the functions calling the analyzer become templates, which forward their `Tables` parameter
+    const std::span<const std::string_view> lines(text);
+    for (auto it = lines.begin(); it != lines.end(); ++it) {
+        if (!it->starts_with("static inline ")) {
+            outp.write(*it).put('\n');
+            continue;
+        }
+        auto it_end = std::find(it, lines.end(), "}") + 1;
+        std::vector<std::string> func(it, it_end);
+        bool calls_analyzer = false;
+        for (auto& l : func) {
+            std::string forwarded = forwardTablesParameter(l);
+            if (forwarded != l) { l = std::move(forwarded), calls_analyzer = true; }
+        }
+        if (calls_analyzer) {
+            outp.write("template<typename Tables = parser_tables>\ninline ");
+            func.front().erase(0, std::string_view("static inline ").size());
+        }
+        for (const auto& l : func) { outp.write(l).put('\n'); }
+        it = it_end - 1;
+    }
+}
+
+void outputBinaryTables(uxs::iobuf& outp, Grammar& grammar, LalrBuilder& lr_builder) {
+    static_assert(static_cast<int>(kTokenError) == parsegen_predef_tt_error, "token identifiers mismatch");
+    std::array<std::vector<int>, parsegen_section_count> sections;
+    std::string strings;
+    auto add_name = [&strings](std::vector<int>& section, unsigned id, std::string_view name) {
+        section.push_back(static_cast<int>(id));
+        section.push_back(static_cast<int>(strings.size()));
+        strings.append(name).push_back('\0');
+    };
+
+    const auto& default_reduce_table = lr_builder.getDefaultReduceTable();
+    auto& default_reduce = sections[parsegen_section_default_reduce];
+    default_reduce.resize(default_reduce_table.size());
+    std::transform(default_reduce_table.begin(), default_reduce_table.end(), default_reduce.begin(), getActionCode);
+
+    const auto& action_table = lr_builder.getCompressedActionTable();
+    auto& action_idx = sections[parsegen_section_action_idx];
+    action_idx.resize(action_table.index.size());
+    std::transform(action_table.index.begin(), action_table.index.end(), action_idx.begin(),
+                   [](unsigned i) { return 2 * i; });
+    for (const auto& [n_state, action] : action_table.data) {
+        sections[parsegen_section_action_list].push_back(n_state);
+        sections[parsegen_section_action_list].push_back(getActionCode(action));
+    }
+
+    const auto& goto_table = lr_builder.getCompressedGotoTable();
+    for (unsigned n_prod = 0; n_prod < grammar.getProductionCount(); ++n_prod) {
+        const auto& prod = grammar.getProductionInfo(n_prod);
+        auto& reduce_info = sections[parsegen_section_reduce_info];
+        reduce_info.push_back(static_cast<int>(prod.rhs.size()));
+        reduce_info.push_back(static_cast<int>(2 * goto_table.index[getIndex(prod.lhs)]));
+        reduce_info.push_back(static_cast<int>(prod.action));
+    }
+    for (const auto& [n_nonterm, n_new_state] : goto_table.data) {
+        sections[parsegen_section_goto_list].push_back(n_nonterm);
+        sections[parsegen_section_goto_list].push_back(static_cast<int>(n_new_state));
+    }
+
+    const auto& error_shift_table = lr_builder.getErrorShiftTable();
+    auto& error_shift = sections[parsegen_section_error_shift];
+    error_shift.resize(error_shift_table.size());
+    std::transform(error_shift_table.begin(), error_shift_table.end(), error_shift.begin(),
+                   [](const LalrBuilder::Action& action) {
+                       return action.type == LalrBuilder::Action::Type::kShift ? static_cast<int>(action.val) : -1;
+                   });
+    // Bitmap row size in 32-bit words goes first
+    std::vector<unsigned> recovery_tokens{(grammar.getTokenCount() + 31) / 32};
+    makeRecoveryTokenBitmaps(grammar, lr_builder, 32, sections[parsegen_section_recovery_idx], recovery_tokens);
+    sections[parsegen_section_recovery_tokens].assign(recovery_tokens.begin(), recovery_tokens.end());
+
+    for (const auto& [name, id] : grammar.getTokenList()) {
+        add_name(sections[parsegen_section_token_names], id, name);
+    }
+    for (const auto& [name, id] : grammar.getActionList()) {
+        add_name(sections[parsegen_section_action_names], id + 1, name);
+    }
+    const auto& start_conditions = grammar.getStartConditions();
+    for (unsigned n = 0; n < start_conditions.size(); ++n) {
+        add_name(sections[parsegen_section_start_conditions], n, start_conditions[n].first);
+    }
+
+    // Header is followed by sections, all values are written in little-endian byte order
+    std::string data(sizeof(parsegen_tables_header), '\0');
+    auto put_value = [&data](std::size_t pos, std::uint32_t v) {
+        for (unsigned n = 0; n < sizeof(v); ++n, v >>= 8) { data[pos + n] = static_cast<char>(v & 0xff); }
+    };
+    auto add_section = [&data, &put_value](unsigned n_section, std::size_t count) {
+        data.resize((data.size() + parsegen_tables_alignment - 1) & ~std::size_t(parsegen_tables_alignment - 1));
+        const std::size_t pos = offsetof(parsegen_tables_header, sections) + n_section * 2 * sizeof(std::uint32_t);
+        put_value(pos, static_cast<std::uint32_t>(data.size()));
+        put_value(pos + sizeof(std::uint32_t), static_cast<std::uint32_t>(count));
+    };
+    put_value(offsetof(parsegen_tables_header, magic), parsegen_tables_magic);
+    put_value(offsetof(parsegen_tables_header, version), parsegen_tables_version);
+    put_value(offsetof(parsegen_tables_header, section_count), parsegen_section_count);
+    for (unsigned n_section = 0; n_section < parsegen_section_count; ++n_section) {
+        if (n_section == parsegen_section_strings) {
+            add_section(n_section, strings.size());
+            data += strings;
+            continue;
+        }
+        add_section(n_section, sections[n_section].size());
+        const std::size_t pos = data.size();
+        data.resize(pos + sections[n_section].size() * sizeof(std::uint32_t));
+        for (std::size_t i = 0; i < sections[n_section].size(); ++i) {
+            put_value(pos + i * sizeof(std::uint32_t), static_cast<std::uint32_t>(sections[n_section][i]));
+        }
+    }
+    data.resize((data.size() + parsegen_tables_alignment - 1) & ~std::size_t(parsegen_tables_alignment - 1));
+    put_value(offsetof(parsegen_tables_header, size), static_cast<std::uint32_t>(data.size()));
+    outp.write(data);
+}
+
+std::vector<std::size_t> makeSyncStates(const LalrBuilder& lr_builder, std::vector<unsigned>& sync_states) {
+    // Entry states of synchronization tokens are stored contiguously, equal lists are shared;
+    // returns the offset of the list of each synchronization token
+    const auto& token_states = lr_builder.getSyncStates();
+    std::vector<std::size_t> offsets;
+    offsets.reserve(token_states.size());
+    for (std::size_t n = 0; n < token_states.size(); ++n) {
+        const auto& states = token_states[n].second;
+        auto it = std::find_if(token_states.begin(), token_states.begin() + n,
+                               [&states](const auto& item) { return item.second == states; });
+        if (it != token_states.begin() + n) {
+            offsets.push_back(offsets[it - token_states.begin()]);
+        } else {
+            offsets.push_back(sync_states.size());
+            sync_states.insert(sync_states.end(), states.begin(), states.end());
+        }
+    }
+    return offsets;
+}
+
+void outputSyncStates(uxs::iobuf& outp, const Grammar& grammar, const LalrBuilder& lr_builder,
+                      const std::vector<std::size_t>& offsets, const EngineSyntax& syntax) {
+    // `sync_states` table is output with other tables
+    const auto& token_states = lr_builder.getSyncStates();
+    std::size_t max_reduce_length = 1;
+    for (const auto& prod : grammar.getProductions()) {
+        max_reduce_length = std::max(max_reduce_length, prod.rhs.size());
+    }
+
+    uxs::print(outp, "\nenum {{ max_reduce_length = {} }};\n", max_reduce_length);
+    uxs::print(outp, "\n/* States, in which synchronization tokens are shifted, for `parsegen/parallel.h` */\n");
+    outputEngineLine(outp, "static inline int get_sync_states(int tt, const int** p_states) {", syntax);
+    uxs::print(outp, "    switch (tt) {{\n");
+    for (std::size_t n = 0; n < token_states.size(); ++n) {
+        if (token_states[n].second.empty()) { continue; }  // Not a synchronization point
+        outputEngineLine(outp,
+                         uxs::format("        case {}: *p_states = &sync_states[{}]; return {};", token_states[n].first,
+                                     offsets[n], token_states[n].second.size()),
+                         syntax);
+    }
+    uxs::print(outp, "        default: break;\n");
+    uxs::print(outp, "    }}\n");
+    uxs::print(outp, "    return 0;\n");
+    uxs::print(outp, "}}\n");
+}
+
+template<typename Ty>
+void outputCaseLabels(uxs::iobuf& outp, const std::vector<Ty>& labels, std::size_t ntab) {
+    const unsigned length_limit = 120;
+    std::string tab(ntab, ' '), line = tab;
+    for (const auto& label : labels) {
+        auto sval = uxs::format("case {}:", label);
+        if (line.length() > ntab && line.length() + sval.length() + 1 > length_limit) {
+            outp.write(line).put('\n');
+            line = tab + sval;
+        } else {
+            line += line.length() > ntab ? ' ' + sval : sval;
+        }
+    }
+    outp.write(line);
+}
+
+// Groups labels of (label, value) pairs by values in order of first occurrence
+template<typename Ty>
+std::vector<std::pair<Ty, std::vector<unsigned>>> groupCaseLabels(const std::vector<std::pair<unsigned, Ty>>& entries) {
+    std::vector<std::pair<Ty, std::vector<unsigned>>> groups;
+    for (const auto& [label, val] : entries) {
+        auto it = std::find_if(groups.begin(), groups.end(), [&val = val](const auto& g) { return g.first == val; });
+        if (it == groups.end()) { it = groups.emplace(groups.end(), val, std::vector<unsigned>()); }
+        it->second.push_back(label);
+    }
+    return groups;
+}
+
+void outputDirectParserEngine(uxs::iobuf& outp, const Grammar& grammar, LalrBuilder& lr_builder) {
+    // Each state is hard-coded as a `switch` by look-ahead token with resolved shifts and jumps to reductions,
+    // each reduction pops its length and jumps to the `switch` of goto column of its left part, so nothing
+    // is decoded at run time; states with equal rows and nonterminals with equal goto columns share code
+    const auto& action_table = lr_builder.getCompressedActionTable();
+    const auto& goto_table = lr_builder.getCompressedGotoTable();
+    std::vector<bool> is_reduced(grammar.getProductionCount(), false);
+    auto action_text = [&is_reduced](const LalrBuilder::Action& action) {
+        switch (action.type) {
+            case LalrBuilder::Action::Type::kShift: {
+                return uxs::format("*sptr = {}, *p_action = predef_act_shift; return sptr + 1;", action.val);
+            }
+            case LalrBuilder::Action::Type::kReduce: {
+                is_reduced[action.val] = true;
+                return uxs::format("goto reduce_{};", action.val);
+            }
+            default: break;
+        }
+        return std::string("*p_action = -1; return sptr;");
+    };
+
+    std::vector<std::pair<unsigned, unsigned>> row_states;
+    row_states.reserve(action_table.index.size());
+    for (unsigned n_state = 0; n_state < action_table.index.size(); ++n_state) {
+        row_states.emplace_back(n_state, action_table.index[n_state]);
+    }
+    uxs::print(outp, "\nstatic parser_state_t* parse_step(int tt, parser_state_t* sptr, int* p_action) {{\n");
+    uxs::print(outp, "    switch (*(sptr - 1)) {{\n");
+    std::vector<std::pair<unsigned, LalrBuilder::Action>> entries;
+    for (const auto& [first, states] : groupCaseLabels(row_states)) {
+        entries.clear();
+        auto it = action_table.data.begin() + first;
+        for (; it->first >= 0; ++it) { entries.emplace_back(static_cast<unsigned>(it->first), it->second); }
+        outputCaseLabels(outp, states, 8);
+        if (entries.empty()) {
+            uxs::print(outp, " {}\n", action_text(it->second));
+            continue;
+        }
+        uxs::print(outp, "\n            switch (tt) {{\n");
+        for (const auto& [action, tokens] : groupCaseLabels(entries)) {
+            outputCaseLabels(outp, tokens, 16);
+            uxs::print(outp, " {}\n", action_text(action));
+        }
+        uxs::print(outp, "            }}\n");
+        uxs::print(outp, "            {}\n", action_text(it->second));
+    }
+    uxs::print(outp, "    }}\n");
+    uxs::print(outp, "    *p_action = -1;\n");
+    uxs::print(outp, "    return sptr;\n");
+
+    std::vector<bool> is_goto_used(goto_table.data.size(), false);
+    for (unsigned n_prod = 0; n_prod < grammar.getProductionCount(); ++n_prod) {
+        if (!is_reduced[n_prod]) { continue; }
+        const auto& prod = grammar.getProductionInfo(n_prod);
+        const unsigned goto_first = goto_table.index[getIndex(prod.lhs)];
+        is_goto_used[goto_first] = true;
+        uxs::print(outp, "reduce_{}:\n", n_prod);
+        if (!prod.rhs.empty()) { uxs::print(outp, "    sptr -= {};\n", prod.rhs.size()); }
+        uxs::print(outp, "    *p_action = predef_act_reduce + {};\n", prod.action);
+        uxs::print(outp, "    goto goto_{};\n", goto_first);
+    }
+
+    std::vector<std::pair<unsigned, unsigned>> goto_entries;
+    for (unsigned first = 0; first < goto_table.data.size(); ++first) {
+        if (!is_goto_used[first]) { continue; }
+        goto_entries.clear();
+        auto it = goto_table.data.begin() + first;
+        for (; it->first >= 0; ++it) { goto_entries.emplace_back(static_cast<unsigned>(it->first), it->second); }
+        uxs::print(outp, "goto_{}:\n", first);
+        if (!goto_entries.empty()) {
+            uxs::print(outp, "    switch (*(sptr - 1)) {{\n");
+            for (const auto& [new_state, states] : groupCaseLabels(goto_entries)) {
+                outputCaseLabels(outp, states, 8);
+                uxs::print(outp, " *sptr = {}; return sptr + 1;\n", new_state);
+            }
+            uxs::print(outp, "    }}\n");
+        }
+        uxs::print(outp, "    *sptr = {};\n", it->second);
+        uxs::print(outp, "    return sptr + 1;\n");
+    }
+    uxs::print(outp, "}}\n");
+
+    std::vector<unsigned> default_reduce_states;
+    const auto& default_reduce_table = lr_builder.getDefaultReduceTable();
+    for (unsigned n_state = 0; n_state < default_reduce_table.size(); ++n_state) {
+        if (default_reduce_table[n_state].type == LalrBuilder::Action::Type::kReduce) {
+            default_reduce_states.push_back(n_state);
+        }
+    }
+    uxs::print(outp, "\nstatic inline int need_lookahead(const parser_state_t* sptr) {{\n");
+    if (!default_reduce_states.empty()) {
+        uxs::print(outp, "    switch (*(sptr - 1)) {{\n");
+        outputCaseLabels(outp, default_reduce_states, 8);
+        uxs::print(outp, " return 0;\n");
+        uxs::print(outp, "    }}\n");
+    }
+    uxs::print(outp, "    return 1;\n");
+    uxs::print(outp, "}}\n");
+
+    // States with equal sets of recovery tokens share the same `case`
+    std::vector<std::pair<const ValueSet*, std::vector<unsigned>>> recovery_states;
+    const auto& recovery_token_table = lr_builder.getRecoveryTokenTable();
+    for (unsigned n_state = 0; n_state < recovery_token_table.size(); ++n_state) {
+        const ValueSet& tokens = recovery_token_table[n_state];
+        if (tokens.empty()) { continue; }
+        auto it = std::find_if(recovery_states.begin(), recovery_states.end(),
+                               [&tokens](const auto& item) { return *item.first == tokens; });
+        if (it == recovery_states.end()) { it = recovery_states.emplace(it, &tokens, std::vector<unsigned>()); }
+        it->second.push_back(n_state);
+    }
+    uxs::print(outp, "\nstatic inline int is_recovery_token(const parser_state_t* sptr, int tt) {{\n");
+    if (!recovery_states.empty()) {
+        uxs::print(outp, "    switch (*(sptr - 1)) {{\n");
+        for (const auto& [tokens, states] : recovery_states) {
+            outputCaseLabels(outp, states, 8);
+            uxs::print(outp, " {{\n");
+            uxs::print(outp, "            switch (tt) {{\n");
+            outputCaseLabels(outp, std::vector<unsigned>(tokens->begin(), tokens->end()), 16);
+            uxs::print(outp, " return 1;\n");
+            uxs::print(outp, "            }}\n");
+            uxs::print(outp, "            return 0;\n");
+            uxs::print(outp, "        }}\n");
+        }
+        uxs::print(outp, "    }}\n");
+    }
+    uxs::print(outp, "    return 1;\n");
+    uxs::print(outp, "}}\n");
+
+    // clang-format off
+    static constexpr std::string_view head_text[] = {
+        "static int parse(int tt, parser_state_t* sptr0, parser_state_t** p_sptr, int rise_error) {",
+        "    parser_state_t* sptr = *p_sptr;",
+        "    int action = rise_error;",
+        "    if (action >= 0) {",
+        "        sptr = parse_step(tt, sptr, &action);",
+        "        if (action >= 0) {",
+        "            *p_sptr = sptr;",
+        "            return action;",
+        "        }",
+        "    }",
+        "    /* Roll back to state, which can accept error, and shift error token */",
+    };
+    // clang-format on
+    outp.put('\n');
+    for (const auto& l : head_text) { outp.write(l).put('\n'); }
+    std::vector<std::pair<unsigned, unsigned>> error_shifts;
+    const auto& error_shift_table = lr_builder.getErrorShiftTable();
+    for (unsigned n_state = 0; n_state < error_shift_table.size(); ++n_state) {
+        if (error_shift_table[n_state].type == LalrBuilder::Action::Type::kShift) {
+            error_shifts.emplace_back(n_state, error_shift_table[n_state].val);
+        }
+    }
+    if (!error_shifts.empty()) {
+        uxs::print(outp, "    do {{\n");
+        uxs::print(outp, "        switch (*(sptr - 1)) {{\n");
+        for (const auto& [new_state, states] : groupCaseLabels(error_shifts)) {
+            outputCaseLabels(outp, states, 12);
+            uxs::print(outp, " *sptr = {}, *p_sptr = sptr + 1; return action;\n", new_state);
+        }
+        uxs::print(outp, "        }}\n");
+        uxs::print(outp, "    }} while (--sptr != sptr0);\n");
+    }
+    uxs::print(outp, "    *p_sptr = sptr0;\n");
+    uxs::print(outp, "    return action;\n");
+    uxs::print(outp, "}}\n");
 }
 
 //---------------------------------------------------------------------------------------
 
 int main(int argc, char** argv) {
     try {
-        bool show_help = false, show_version = false;
+        bool show_help = false, show_version = false, show_stats = false, eliminate_unit_prods = false;
+        bool session = false;
         std::string input_file_name;
         std::string analyzer_file_name("parser_analyzer.inl");
         std::string defs_file_name("parser_defs.h");
         std::string report_file_name;
+        std::string binary_file_name;
+        std::string lookahead_method("relations");
+        std::string table_format("list");
+        std::string engine("table");
+        std::string language("c");
+        std::string state_type("int");
+        unsigned job_count = 1;
         auto cli = uxs::cli::command(argv[0])
                    << uxs::cli::overview("A tool for LALR-grammar based parser generation")
                    << uxs::cli::value("file", input_file_name)
@@ -103,6 +1078,30 @@ int main(int argc, char** argv) {
                           "Place the output analyzer into <file>."
                    << (uxs::cli::option({"--header-file="}) & uxs::cli::value("<file>", defs_file_name)) %
                           "Place the output definitions into <file>."
+                   << (uxs::cli::option({"--binary-out="}) & uxs::cli::value("<file>", binary_file_name)) %
+                          "Also place the output tables into binary <file> for `parsegen/runtime.h`."
+                   << (uxs::cli::option({"--lookahead-method="}) & uxs::cli::value("<method>", lookahead_method)) %
+                          "Use <method> for look-ahead set calculation: `relations` (DeRemer-Pennello, default) or "
+                          "`propagation` (spontaneous generation and propagation)."
+                   << (uxs::cli::option({"--table-format="}) & uxs::cli::value("<format>", table_format)) %
+                          "Use <format> for output tables: `list` (lists of non-default entries, default) or `comb` "
+                          "(row displacement tables with constant lookup time)."
+                   << (uxs::cli::option({"--engine="}) & uxs::cli::value("<engine>", engine)) %
+                          "Use <engine> for the output analyzer: `table` (table interpreter, default) or `direct` "
+                          "(states are hard-coded as `switch` statements with resolved actions)."
+                   << (uxs::cli::option({"--language="}) & uxs::cli::value("<lang>", language)) %
+                          "Use <lang> for the output analyzer: `c` (default) or `c++20` (`constexpr` tables in a "
+                          "structure and `parse<Tables>()` template)."
+                   << (uxs::cli::option({"--state-type="}) & uxs::cli::value("<type>", state_type)) %
+                          "Use <type> for state stack entries: `int` (default) or `int16_t` (halves the stack for "
+                          "grammars with less than 32768 states)."
+                   << uxs::cli::option({"--session"}).set(session) %
+                          "Output `parser_session` runtime, which owns the state stack."
+                   << uxs::cli::option({"--eliminate-unit-productions"}).set(eliminate_unit_prods) %
+                          "Bypass reductions of unit productions without actions in goto transitions."
+                   << (uxs::cli::option({"-j", "--jobs"}) & uxs::cli::value("<n>", job_count)) %
+                          "Use <n> threads to build the analyzer."
+                   << uxs::cli::option({"--stats"}).set(show_stats) % "Print analyzer builder statistics."
                    << uxs::cli::option({"-h", "--help"}).set(show_help) % "Display this information."
                    << uxs::cli::option({"-V", "--version"}).set(show_version) % "Display version.";
 
@@ -134,6 +1133,43 @@ int main(int argc, char** argv) {
             return -1;
         }
 
+        LalrBuilder::LookAheadMethod lr_lookahead_method = LalrBuilder::LookAheadMethod::kRelations;
+        if (lookahead_method == "propagation") {
+            lr_lookahead_method = LalrBuilder::LookAheadMethod::kPropagation;
+        } else if (lookahead_method != "relations") {
+            logger::fatal().println("unknown look-ahead calculation method `{}`", lookahead_method);
+            return -1;
+        }
+
+        LalrBuilder::TableFormat lr_table_format = LalrBuilder::TableFormat::kList;
+        if (table_format == "comb") {
+            lr_table_format = LalrBuilder::TableFormat::kComb;
+        } else if (table_format != "list") {
+            logger::fatal().println("unknown table format `{}`", table_format);
+            return -1;
+        }
+
+        if (engine != "table" && engine != "direct") {
+            logger::fatal().println("unknown analyzer engine `{}`", engine);
+            return -1;
+        } else if (engine == "direct" && lr_table_format != LalrBuilder::TableFormat::kList) {
+            logger::fatal().println("table format `{}` is not supported by `{}` analyzer engine", table_format, engine);
+            return -1;
+        }
+
+        if (language != "c" && language != "c++20") {
+            logger::fatal().println("unknown output language `{}`", language);
+            return -1;
+        } else if (language != "c" && engine == "direct") {
+            logger::fatal().println("output language `{}` is not supported by `{}` analyzer engine", language, engine);
+            return -1;
+        }
+
+        if (state_type != "int" && state_type != "int16_t") {
+            logger::fatal().println("unknown state type `{}`", state_type);
+            return -1;
+        }
+
         uxs::filebuf ifile(input_file_name.c_str(), "r");
         if (!ifile) {
             logger::fatal().println("could not open input file `{}`", input_file_name);
@@ -145,6 +1181,10 @@ int main(int argc, char** argv) {
         if (!parser.parse()) { return -1; }
 
         LalrBuilder lr_builder(grammar);
+        lr_builder.setLookAheadMethod(lr_lookahead_method);
+        lr_builder.setJobCount(job_count);
+        lr_builder.setTableFormat(lr_table_format);
+        lr_builder.setUnitProductionElimination(eliminate_unit_prods);
 
         logger::info(input_file_name).println("\033[1;34mbuilding analyzer...\033[0m");
         lr_builder.build();
@@ -154,6 +1194,30 @@ int main(int argc, char** argv) {
                      !lr_builder.getSRConflictCount() && !lr_builder.getRRConflictCount() ? "\033[1;32m" : "\033[1;33m",
                      lr_builder.getSRConflictCount(), lr_builder.getRRConflictCount());
 
+        if (show_stats) {
+            const auto& stats = lr_builder.getStatistics();
+            logger::info(input_file_name)
+                .println(" - {} states: {} lookups, {} probes, {} hash collisions", lr_builder.getStateCount(),
+                         stats.state_lookups, stats.state_probes, stats.state_collisions);
+            logger::info(input_file_name).println(" - {} distinct kernel item closures", stats.item_closure_count);
+            logger::info(input_file_name).println(" - {} states with default reduction", stats.default_reduce_count);
+            if (eliminate_unit_prods) {
+                std::size_t unit_reduction_count = 0;
+                for (const auto& [n_state, count] : stats.unit_reductions) { unit_reduction_count += count; }
+                logger::info(input_file_name)
+                    .println(" - {} unit reduction(s) removed in {} states", unit_reduction_count,
+                             stats.unit_reductions.size());
+                for (const auto& [n_state, count] : stats.unit_reductions) {
+                    logger::info(input_file_name).println("   state {}: {} unit reduction(s)", n_state, count);
+                }
+            }
+        }
+
+        if (state_type == "int16_t" && lr_builder.getStateCount() > INT16_MAX) {
+            logger::fatal().println("{} states don't fit into state type `{}`", lr_builder.getStateCount(), state_type);
+            return -1;
+        }
+
         if (!report_file_name.empty()) {
             if (uxs::filebuf ofile(report_file_name.c_str(), "w"); ofile) {
                 grammar.printTokens(ofile);
@@ -213,55 +1277,135 @@ int main(int argc, char** argv) {
             logger::error().println("could not open output file `{}`", defs_file_name);
         }
 
-        const auto& action_table = lr_builder.getCompressedActionTable();
-        std::vector<int> action_idx(action_table.index.size()), action_list;
-        action_list.reserve(2 * action_table.data.size());
-        auto action_code = [](const LalrBuilder::Action& action) {
-            enum { shift_flag = 1, flag_count = 1 };
-            switch (action.type) {
-                case LalrBuilder::Action::Type::kShift: return static_cast<int>(action.val << flag_count) | shift_flag;
-                case LalrBuilder::Action::Type::kReduce: return static_cast<int>(3 * action.val) << flag_count;
-                default: break;
-            }
-            return -1;
-        };
-        std::transform(action_table.index.begin(), action_table.index.end(), action_idx.begin(),
-                       [](unsigned i) { return 2 * i; });
-        for (const auto& [n_state, action] : action_table.data) {
-            action_list.push_back(n_state);
-            action_list.push_back(action_code(action));
-        }
-
-        const auto& goto_table = lr_builder.getCompressedGotoTable();
-        std::vector<int> goto_list;
-        goto_list.reserve(2 * goto_table.data.size());
-        for (const auto& [n_nonterm, n_new_state] : goto_table.data) {
-            goto_list.push_back(n_nonterm);
-            goto_list.push_back(n_new_state);
-        }
-
         if (uxs::filebuf ofile(analyzer_file_name.c_str(), "w"); ofile) {
             uxs::print(ofile, "/* Parsegen autogenerated analyzer file - do not edit! */\n");
             uxs::print(ofile, "/* clang-format off */\n");
-            outputArray(ofile, "action_idx", action_idx.begin(), action_idx.end());
-            outputArray(ofile, "action_list", action_list.begin(), action_list.end());
-
-            std::vector<int> reduce_info;
-            reduce_info.reserve(3 * grammar.getProductionCount());
-            for (unsigned n_prod = 0; n_prod < grammar.getProductionCount(); ++n_prod) {
-                const auto& prod = grammar.getProductionInfo(n_prod);
-                reduce_info.push_back(static_cast<int>(prod.rhs.size()));         // Length
-                reduce_info.push_back(2 * goto_table.index[getIndex(prod.lhs)]);  // Goto index
-                reduce_info.push_back(prod.action);                               // Action on reduce
-            }
+            uxs::print(ofile, "\ntypedef {} parser_state_t;\n", state_type);
+            const bool cpp = language == "c++20";
+            std::vector<unsigned> sync_states;
+            const auto sync_offsets = makeSyncStates(lr_builder, sync_states);
+            if (engine == "direct") {
+                outputArray(ofile, "sync_states", sync_states.begin(), sync_states.end(), "int");
+                outputDirectParserEngine(ofile, grammar, lr_builder);
+            } else {
+                const auto& default_reduce_table = lr_builder.getDefaultReduceTable();
+                std::vector<int> default_reduce(default_reduce_table.size());
+                std::transform(default_reduce_table.begin(), default_reduce_table.end(), default_reduce.begin(),
+                               getActionCode);
+                auto output_table = [&ofile, cpp](std::string_view name, const auto& tbl,
+                                                  std::string_view type_name = {}) {
+                    if (cpp) {
+                        outputStdArray(ofile, name, tbl.begin(), tbl.end(), type_name);
+                    } else {
+                        outputArray(ofile, name, tbl.begin(), tbl.end(), type_name);
+                    }
+                };
+
+                if (cpp) {
+                    outputCppPrologue(ofile);
+                    uxs::print(ofile, "\nstruct parser_tables {{");
+                }
+                output_table("default_reduce", default_reduce);
+
+                const auto& error_shift_table = lr_builder.getErrorShiftTable();
+                std::vector<int> error_shift(error_shift_table.size());
+                std::transform(error_shift_table.begin(), error_shift_table.end(), error_shift.begin(),
+                               [](const LalrBuilder::Action& action) {
+                                   return action.type == LalrBuilder::Action::Type::kShift ?
+                                              static_cast<int>(action.val) :
+                                              -1;
+                               });
+                std::vector<int> recovery_idx;
+                std::vector<unsigned> recovery_tokens;
+                makeRecoveryTokenBitmaps(grammar, lr_builder, 8, recovery_idx, recovery_tokens);
+                output_table("error_shift", error_shift);
+                output_table("recovery_idx", recovery_idx);
+                output_table("recovery_tokens", recovery_tokens, "uint8_t");
+
+                std::vector<ReduceInfo> reduce_info;
+                reduce_info.reserve(grammar.getProductionCount());
+                if (lr_table_format == LalrBuilder::TableFormat::kComb) {
+                    const auto& action_table = lr_builder.getCombActionTable();
+                    std::vector<int> action_def(action_table.def.size());
+                    std::vector<int> action_next(action_table.data.size()), action_check(action_table.data.size());
+                    std::transform(action_table.def.begin(), action_table.def.end(), action_def.begin(), getActionCode);
+                    for (std::size_t i = 0; i < action_table.data.size(); ++i) {
+                        action_check[i] = action_table.data[i].first;
+                        action_next[i] = getActionCode(action_table.data[i].second);
+                    }
+
+                    const auto& goto_table = lr_builder.getCombGotoTable();
+                    std::vector<int> goto_next(goto_table.data.size()), goto_check(goto_table.data.size());
+                    for (std::size_t i = 0; i < goto_table.data.size(); ++i) {
+                        goto_check[i] = goto_table.data[i].first;
+                        goto_next[i] = goto_table.data[i].first >= 0 ? static_cast<int>(goto_table.data[i].second) : -1;
+                    }
 
-            outputArray(ofile, "reduce_info", reduce_info.begin(), reduce_info.end());
-            outputArray(ofile, "goto_list", goto_list.begin(), goto_list.end());
-            outputParserEngine(ofile);
+                    for (unsigned n_prod = 0; n_prod < grammar.getProductionCount(); ++n_prod) {
+                        const auto& prod = grammar.getProductionInfo(n_prod);
+                        reduce_info.push_back(
+                            {static_cast<unsigned>(prod.rhs.size()), getIndex(prod.lhs), prod.action});
+                    }
+
+                    output_table("action_def", action_def);
+                    output_table("action_base", action_table.base);
+                    output_table("action_next", action_next);
+                    output_table("action_check", action_check);
+                    outputReduceInfo(ofile, reduce_info, cpp);
+                    output_table("goto_def", goto_table.def);
+                    output_table("goto_base", goto_table.base);
+                    output_table("goto_next", goto_next);
+                    output_table("goto_check", goto_check);
+                } else {
+                    const auto& action_table = lr_builder.getCompressedActionTable();
+                    std::vector<int> action_idx(action_table.index.size()), action_list;
+                    action_list.reserve(2 * action_table.data.size());
+                    std::transform(action_table.index.begin(), action_table.index.end(), action_idx.begin(),
+                                   [](unsigned i) { return 2 * i; });
+                    for (const auto& [n_state, action] : action_table.data) {
+                        action_list.push_back(n_state);
+                        action_list.push_back(getActionCode(action));
+                    }
+
+                    const auto& goto_table = lr_builder.getCompressedGotoTable();
+                    std::vector<int> goto_list;
+                    goto_list.reserve(2 * goto_table.data.size());
+                    for (const auto& [n_nonterm, n_new_state] : goto_table.data) {
+                        goto_list.push_back(n_nonterm);
+                        goto_list.push_back(n_new_state);
+                    }
+
+                    for (unsigned n_prod = 0; n_prod < grammar.getProductionCount(); ++n_prod) {
+                        const auto& prod = grammar.getProductionInfo(n_prod);
+                        reduce_info.push_back({static_cast<unsigned>(prod.rhs.size()),
+                                               2 * goto_table.index[getIndex(prod.lhs)], prod.action});
+                    }
+
+                    output_table("action_idx", action_idx);
+                    output_table("action_list", action_list);
+                    outputReduceInfo(ofile, reduce_info, cpp);
+                    output_table("goto_list", goto_list);
+                }
+                if (!sync_states.empty()) { output_table("sync_states", sync_states, "int"); }
+                if (cpp) { uxs::print(ofile, "}};\n"); }
+                outputTableParserEngine(ofile, lr_table_format, cpp ? kCppEngineSyntax : kCEngineSyntax);
+            }
+            if (!lr_builder.getSyncStates().empty()) {
+                outputSyncStates(ofile, grammar, lr_builder, sync_offsets, cpp ? kCppEngineSyntax : kCEngineSyntax);
+            }
+            if (session) { outputParserSession(ofile, cpp); }
         } else {
             logger::error().println("could not open output file `{}`", analyzer_file_name);
         }
 
+        if (!binary_file_name.empty()) {
+            if (uxs::filebuf ofile(binary_file_name.c_str(), "w"); ofile) {
+                outputBinaryTables(ofile, grammar, lr_builder);
+            } else {
+                logger::error().println("could not open output file `{}`", binary_file_name);
+            }
+        }
+
         return 0;
     } catch (const std::exception& e) { logger::fatal().println("exception caught: {}", e.what()); }
     return -1;
@@ -105,6 +105,32 @@ bool Parser::parse() {
                 }
                 prec++;
             } break;
+            case tt_sync: {  // Synchronization token definition
+                bool is_empty = true;
+                while (true) {
+                    unsigned id = 0;
+                    switch (tt = lex()) {
+                        case tt_id:
+                        case tt_internal_id: {
+                            id = grammar_.addToken(std::string(std::get<std::string_view>(tkn_.val))).first;
+                        } break;
+                        case tt_symb: {
+                            id = std::get<unsigned>(tkn_.val);
+                        } break;
+                    }
+                    if (id == 0) { break; }
+
+                    if (!grammar_.addSyncToken(id)) {
+                        logger::error(*this, tkn_.loc).println("synchronization token is already defined");
+                        return false;
+                    }
+                    is_empty = false;
+                }
+                if (is_empty) {
+                    logSyntaxError(tt);
+                    return false;
+                }
+            } break;
             case tt_option: {  // Option
                 if ((tt = lex()) != tt_id) {
                     logSyntaxError(tt);
@@ -426,6 +452,7 @@ int Parser::lex() {
             case lex_detail::pat_right: return tt_right;
             case lex_detail::pat_nonassoc: return tt_nonassoc;
             case lex_detail::pat_prec: return tt_prec;
+            case lex_detail::pat_sync: return tt_sync;
             case lex_detail::pat_sep: return tt_sep;
             case lex_detail::pat_other: return static_cast<unsigned char>(*lexeme);
             case lex_detail::pat_whitespace: tkn_.loc.col_first = col_; break;
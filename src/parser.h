@@ -23,6 +23,7 @@ enum {
     tt_right,
     tt_nonassoc,
     tt_prec,
+    tt_sync,
     tt_sep,
     tt_lexical_error,
 };
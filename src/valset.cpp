@@ -2,27 +2,251 @@
 
 #include <algorithm>
 
-bool ValueSet::empty() const {
-    return std::all_of(set_.begin(), set_.end(), [](const auto& w) { return w == 0; });
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#    define VALSET_USE_X86_KERNELS
+#    include <immintrin.h>
+#endif
+
+namespace {
+using Word = unsigned long;
+
+// Bitwise operations are applied to whole word arrays; vector kernels handle blocks of
+// the vector size, the rest of words is handled by scalar loop
+
+struct OrOp {
+    static Word apply(Word w1, Word w2) { return w1 | w2; }
+#if defined(VALSET_USE_X86_KERNELS)
+    static __m128i apply(__m128i v1, __m128i v2) { return _mm_or_si128(v1, v2); }
+    __attribute__((target("avx2"))) static __m256i apply(__m256i v1, __m256i v2) { return _mm256_or_si256(v1, v2); }
+#endif
+};
+
+struct AndOp {
+    static Word apply(Word w1, Word w2) { return w1 & w2; }
+#if defined(VALSET_USE_X86_KERNELS)
+    static __m128i apply(__m128i v1, __m128i v2) { return _mm_and_si128(v1, v2); }
+    __attribute__((target("avx2"))) static __m256i apply(__m256i v1, __m256i v2) { return _mm256_and_si256(v1, v2); }
+#endif
+};
+
+struct XorOp {
+    static Word apply(Word w1, Word w2) { return w1 ^ w2; }
+#if defined(VALSET_USE_X86_KERNELS)
+    static __m128i apply(__m128i v1, __m128i v2) { return _mm_xor_si128(v1, v2); }
+    __attribute__((target("avx2"))) static __m256i apply(__m256i v1, __m256i v2) { return _mm256_xor_si256(v1, v2); }
+#endif
+};
+
+struct AndNotOp {
+    static Word apply(Word w1, Word w2) { return w1 & ~w2; }
+#if defined(VALSET_USE_X86_KERNELS)
+    static __m128i apply(__m128i v1, __m128i v2) { return _mm_andnot_si128(v2, v1); }
+    __attribute__((target("avx2"))) static __m256i apply(__m256i v1, __m256i v2) {
+        return _mm256_andnot_si256(v2, v1);
+    }
+#endif
+};
+
+template<typename Op>
+void applyScalar(Word* dst, const Word* src, std::size_t count) {
+    for (std::size_t n = 0; n < count; ++n) { dst[n] = Op::apply(dst[n], src[n]); }
+}
+
+bool orChangedScalar(Word* dst, const Word* src, std::size_t count) {
+    Word diff = 0;
+    for (std::size_t n = 0; n < count; ++n) { diff |= src[n] & ~dst[n], dst[n] |= src[n]; }
+    return diff != 0;
+}
+
+bool isZeroScalar(const Word* src, std::size_t count) {
+    Word acc = 0;
+    for (std::size_t n = 0; n < count; ++n) { acc |= src[n]; }
+    return acc == 0;
+}
+
+#if defined(VALSET_USE_X86_KERNELS)
+const std::size_t kWordsPerSse = sizeof(__m128i) / sizeof(Word);
+const std::size_t kWordsPerAvx = sizeof(__m256i) / sizeof(Word);
+
+template<typename Op>
+void applySse2(Word* dst, const Word* src, std::size_t count) {
+    std::size_t n = 0;
+    for (; n + kWordsPerSse <= count; n += kWordsPerSse) {
+        __m128i v = Op::apply(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + n)),
+                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), v);
+    }
+    applyScalar<Op>(dst + n, src + n, count - n);
+}
+
+bool orChangedSse2(Word* dst, const Word* src, std::size_t count) {
+    __m128i diff = _mm_setzero_si128();
+    std::size_t n = 0;
+    for (; n + kWordsPerSse <= count; n += kWordsPerSse) {
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + n));
+        __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+        diff = _mm_or_si128(diff, _mm_andnot_si128(v1, v2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), _mm_or_si128(v1, v2));
+    }
+    bool changed = _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xffff;
+    return orChangedScalar(dst + n, src + n, count - n) || changed;
 }
 
+bool isZeroSse2(const Word* src, std::size_t count) {
+    __m128i acc = _mm_setzero_si128();
+    std::size_t n = 0;
+    for (; n + kWordsPerSse <= count; n += kWordsPerSse) {
+        acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)));
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xffff &&
+           isZeroScalar(src + n, count - n);
+}
+
+template<typename Op>
+__attribute__((target("avx2"))) void applyAvx2(Word* dst, const Word* src, std::size_t count) {
+    std::size_t n = 0;
+    for (; n + kWordsPerAvx <= count; n += kWordsPerAvx) {
+        __m256i v = Op::apply(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + n)),
+                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), v);
+    }
+    applyScalar<Op>(dst + n, src + n, count - n);
+}
+
+__attribute__((target("avx2"))) bool orChangedAvx2(Word* dst, const Word* src, std::size_t count) {
+    __m256i diff = _mm256_setzero_si256();
+    std::size_t n = 0;
+    for (; n + kWordsPerAvx <= count; n += kWordsPerAvx) {
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + n));
+        __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+        diff = _mm256_or_si256(diff, _mm256_andnot_si256(v1, v2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), _mm256_or_si256(v1, v2));
+    }
+    bool changed = !_mm256_testz_si256(diff, diff);
+    return orChangedScalar(dst + n, src + n, count - n) || changed;
+}
+
+__attribute__((target("avx2"))) bool isZeroAvx2(const Word* src, std::size_t count) {
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t n = 0;
+    for (; n + kWordsPerAvx <= count; n += kWordsPerAvx) {
+        acc = _mm256_or_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n)));
+    }
+    return _mm256_testz_si256(acc, acc) && isZeroScalar(src + n, count - n);
+}
+#endif  // defined(VALSET_USE_X86_KERNELS)
+
+struct Kernels {
+    void (*bitwise_or)(Word*, const Word*, std::size_t);
+    void (*bitwise_and)(Word*, const Word*, std::size_t);
+    void (*bitwise_xor)(Word*, const Word*, std::size_t);
+    void (*bitwise_and_not)(Word*, const Word*, std::size_t);
+    bool (*or_changed)(Word*, const Word*, std::size_t);
+    bool (*is_zero)(const Word*, std::size_t);
+};
+
+const Kernels kScalarKernels{applyScalar<OrOp>,     applyScalar<AndOp>, applyScalar<XorOp>,
+                             applyScalar<AndNotOp>, orChangedScalar,    isZeroScalar};
+#if defined(VALSET_USE_X86_KERNELS)
+const Kernels kSse2Kernels{applySse2<OrOp>,     applySse2<AndOp>, applySse2<XorOp>,
+                           applySse2<AndNotOp>, orChangedSse2,    isZeroSse2};
+const Kernels kAvx2Kernels{applyAvx2<OrOp>,     applyAvx2<AndOp>, applyAvx2<XorOp>,
+                           applyAvx2<AndNotOp>, orChangedAvx2,    isZeroAvx2};
+#endif  // defined(VALSET_USE_X86_KERNELS)
+
+// Returns `nullptr` if the kernel set is not supported by the CPU
+const Kernels* findKernels(ValueSet::KernelSet kernel_set) {
+#if defined(VALSET_USE_X86_KERNELS)
+    __builtin_cpu_init();
+    switch (kernel_set) {
+        case ValueSet::KernelSet::kAvx2: return __builtin_cpu_supports("avx2") ? &kAvx2Kernels : nullptr;
+        case ValueSet::KernelSet::kSse2: return __builtin_cpu_supports("sse2") ? &kSse2Kernels : nullptr;
+        default: break;
+    }
+#else   // defined(VALSET_USE_X86_KERNELS)
+    if (kernel_set != ValueSet::KernelSet::kScalar) { return nullptr; }
+#endif  // defined(VALSET_USE_X86_KERNELS)
+    return &kScalarKernels;
+}
+
+// The best kernel set is selected once on first use
+const Kernels*& getKernelsPtr() {
+    static const Kernels* kernels = [] {
+        for (auto kernel_set : {ValueSet::KernelSet::kAvx2, ValueSet::KernelSet::kSse2}) {
+            if (const Kernels* found = findKernels(kernel_set)) { return found; }
+        }
+        return &kScalarKernels;
+    }();
+    return kernels;
+}
+
+const Kernels& getKernels() { return *getKernelsPtr(); }
+}  // namespace
+
+bool ValueSet::selectKernels(KernelSet kernel_set) {
+    const Kernels* kernels = findKernels(kernel_set);
+    if (!kernels) { return false; }
+    getKernelsPtr() = kernels;
+    return true;
+}
+
+ValueSet& ValueSet::operator=(const ValueSet& other) {
+    if (&other == this) { return *this; }
+    if (other.size_ > capacity_) {
+        auto* heap = new unsigned long[other.size_];
+        if (capacity_ > kInlineWordCount) { delete[] heap_; }
+        heap_ = heap, capacity_ = other.size_;
+    }
+    std::copy_n(other.data(), other.size_, data());
+    size_ = other.size_;
+    return *this;
+}
+
+ValueSet& ValueSet::operator=(ValueSet&& other) noexcept {
+    if (&other == this) { return *this; }
+    if (other.capacity_ > kInlineWordCount) {
+        if (capacity_ > kInlineWordCount) { delete[] heap_; }
+        heap_ = other.heap_, capacity_ = other.capacity_;
+        other.inline_ = 0, other.capacity_ = kInlineWordCount;
+    } else {
+        std::copy_n(other.data(), other.size_, data());
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+    return *this;
+}
+
+void ValueSet::grow(unsigned size) {
+    if (size <= size_) { return; }
+    if (size > capacity_) {
+        // Sets don't outgrow the grammar, so the storage is not reserved ahead
+        auto* heap = new unsigned long[size];
+        std::copy_n(data(), size_, heap);
+        if (capacity_ > kInlineWordCount) { delete[] heap_; }
+        heap_ = heap, capacity_ = size;
+    }
+    std::fill(data() + size_, data() + size, 0ul);
+    size_ = size;
+}
+
+bool ValueSet::empty() const { return getKernels().is_zero(data(), size_); }
+
 unsigned ValueSet::getFirstValue() const {
     unsigned v = 0;
-    for (const auto& w : set_) {
-        if (w) { return v + detail::lsb(w); }
-        v += kBitsPerWord;
+    for (const unsigned long *it = data(), *it_end = it + size_; it != it_end; ++it, v += kBitsPerWord) {
+        if (*it) { return v + detail::lsb(*it); }
     }
     return v;
 }
 
 unsigned ValueSet::getNextValue(unsigned v) const {
-    assert(v <= kMaxValue);
-    auto it = set_.begin() + nword(v++);
+    assert(v < size_ * kBitsPerWord);
+    const unsigned long *it = data() + nword(v++), *it_end = data() + size_;
     if (unsigned n = nbit(v); n && (*it >> n)) {
         v += detail::lsb(*it >> n);
     } else {
         v = detail::alignUp(v, kBitsPerWord);
-        for (++it; it != set_.end(); ++it, v += kBitsPerWord) {
+        for (++it; it != it_end; ++it, v += kBitsPerWord) {
             if (*it) { return v + detail::lsb(*it); }
         }
     }
@@ -30,51 +254,65 @@ unsigned ValueSet::getNextValue(unsigned v) const {
 }
 
 ValueSet& ValueSet::addValues(unsigned from, unsigned to) {
-    assert(from <= to && to <= kMaxValue);
-    auto it = set_.begin() + nword(from), it_last = set_.begin() + nword(++to);
+    assert(from <= to);
+    grow(nword(to) + 1);
+    unsigned long *it = data() + nword(from), *it_last = data() + nword(++to);
     if (it == it_last) {
         *it |= ~(bitmask(from) - 1) & (bitmask(to) - 1);
     } else {
         *it++ |= ~(bitmask(from) - 1);
         while (it != it_last) { *it++ = ~0ul; }
-        if (it_last != set_.end()) { *it_last |= bitmask(to) - 1; }
+        if (it_last != data() + size_) { *it_last |= bitmask(to) - 1; }
     }
     return *this;
 }
 
 ValueSet& ValueSet::removeValues(unsigned from, unsigned to) {
-    assert(from <= to && to <= kMaxValue);
-    auto it = set_.begin() + nword(from), it_last = set_.begin() + nword(++to);
+    assert(from <= to);
+    if (nword(from) >= size_) { return *this; }
+    to = std::min(to, size_ * kBitsPerWord - 1);
+    unsigned long *it = data() + nword(from), *it_last = data() + nword(++to);
     if (it == it_last) {
         *it &= (bitmask(from) - 1) | ~(bitmask(to) - 1);
     } else {
         *it++ &= bitmask(from) - 1;
         while (it != it_last) { *it++ = 0ul; }
-        if (it_last != set_.end()) { *it_last &= ~(bitmask(to) - 1); }
+        if (it_last != data() + size_) { *it_last &= ~(bitmask(to) - 1); }
     }
     return *this;
 }
 
+bool ValueSet::orChanged(const ValueSet& rhs) {
+    grow(rhs.size_);
+    return getKernels().or_changed(data(), rhs.data(), rhs.size_);
+}
+
 ValueSet& ValueSet::operator|=(const ValueSet& rhs) {
-    std::transform(set_.begin(), set_.end(), rhs.set_.begin(), set_.begin(),
-                   [](const auto& w1, const auto& w2) { return w1 | w2; });
+    grow(rhs.size_);
+    getKernels().bitwise_or(data(), rhs.data(), rhs.size_);
     return *this;
 }
 
 ValueSet& ValueSet::operator&=(const ValueSet& rhs) {
-    std::transform(set_.begin(), set_.end(), rhs.set_.begin(), set_.begin(),
-                   [](const auto& w1, const auto& w2) { return w1 & w2; });
+    size_ = std::min(size_, rhs.size_);
+    getKernels().bitwise_and(data(), rhs.data(), size_);
     return *this;
 }
 
 ValueSet& ValueSet::operator^=(const ValueSet& rhs) {
-    std::transform(set_.begin(), set_.end(), rhs.set_.begin(), set_.begin(),
-                   [](const auto& w1, const auto& w2) { return w1 ^ w2; });
+    grow(rhs.size_);
+    getKernels().bitwise_xor(data(), rhs.data(), rhs.size_);
     return *this;
 }
 
 ValueSet& ValueSet::operator-=(const ValueSet& rhs) {
-    std::transform(set_.begin(), set_.end(), rhs.set_.begin(), set_.begin(),
-                   [](const auto& w1, const auto& w2) { return w1 & ~w2; });
+    getKernels().bitwise_and_not(data(), rhs.data(), std::min(size_, rhs.size_));
     return *this;
 }
+
+bool operator==(const ValueSet& lhs, const ValueSet& rhs) {
+    const ValueSet& longer = lhs.size_ >= rhs.size_ ? lhs : rhs;
+    const unsigned common_size = std::min(lhs.size_, rhs.size_);
+    return std::equal(lhs.data(), lhs.data() + common_size, rhs.data()) &&
+           getKernels().is_zero(longer.data() + common_size, longer.size_ - common_size);
+}
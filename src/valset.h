@@ -1,29 +1,36 @@
 #pragma once
 
-#include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <iterator>
 #include <memory>
 
 namespace detail {
-constexpr unsigned lsb(unsigned long v) {
-    unsigned r = 0;
-    while (!(v & 1)) { v >>= 1, ++r; }
-    return r;
-}
+constexpr unsigned lsb(unsigned long v) { return static_cast<unsigned>(std::countr_zero(v)); }
 constexpr unsigned alignUp(unsigned v, unsigned base) { return (v + base - 1) & ~(base - 1); }
 }  // namespace detail
 
+// Set of unsigned values represented as a bit array which grows up to the greatest contained value:
+// the storage is sized by contents, so it never exceeds the token or nonterminal count of the grammar,
+// sets of values less than the word width are kept inline in place of the heap pointer
 class ValueSet {
  public:
-    ValueSet() { set_.fill(0); }
-    ValueSet(unsigned from, unsigned to) {
-        set_.fill(0);
-        addValues(from, to);
+    ValueSet() = default;
+    ValueSet(unsigned from, unsigned to) { addValues(from, to); }
+    ValueSet(const ValueSet& other) { *this = other; }
+    ValueSet(ValueSet&& other) noexcept { *this = std::move(other); }
+    ValueSet& operator=(const ValueSet& other);
+    ValueSet& operator=(ValueSet&& other) noexcept;
+    ~ValueSet() {
+        if (capacity_ > kInlineWordCount) { delete[] heap_; }
     }
 
-    static const unsigned kMaxValue = 1023;
+    enum class KernelSet { kScalar = 0, kSse2, kAvx2 };
+
+    // Replaces automatically selected kernels of bitwise operations, e.g. for benchmarking;
+    // returns `false` if the kernel set is not supported, must not be called concurrently with set operations
+    static bool selectKernels(KernelSet kernel_set);
 
     class Iterator {
      public:
@@ -63,31 +70,29 @@ class ValueSet {
 
     bool empty() const;
     Iterator begin() const { return Iterator(this, getFirstValue()); }
-    Iterator end() const { return Iterator(this, kMaxValue + 1); }
+    Iterator end() const { return Iterator(this, size_ * kBitsPerWord); }
     unsigned getFirstValue() const;
     unsigned getNextValue(unsigned v) const;
-    bool contains(unsigned v) const {
-        assert(v <= kMaxValue);
-        return set_[nword(v)] & bitmask(v);
-    }
+    bool contains(unsigned v) const { return nword(v) < size_ && (data()[nword(v)] & bitmask(v)); }
 
     ValueSet& clear() {
-        set_.fill(0);
+        size_ = 0;
         return *this;
     }
     ValueSet& addValue(unsigned v) {
-        assert(v <= kMaxValue);
-        set_[nword(v)] |= bitmask(v);
+        grow(nword(v) + 1);
+        data()[nword(v)] |= bitmask(v);
         return *this;
     }
     ValueSet& addValues(unsigned from, unsigned to);
     ValueSet& removeValue(unsigned v) {
-        assert(v <= kMaxValue);
-        set_[nword(v)] &= ~bitmask(v);
+        if (nword(v) < size_) { data()[nword(v)] &= ~bitmask(v); }
         return *this;
     }
     ValueSet& removeValues(unsigned from, unsigned to);
 
+    bool orChanged(const ValueSet& rhs);  // Returns `true` if new values are added
+
     ValueSet& operator|=(const ValueSet& rhs);
     ValueSet& operator&=(const ValueSet& rhs);
     ValueSet& operator^=(const ValueSet& rhs);
@@ -109,16 +114,26 @@ class ValueSet {
         ValueSet ret = lhs;
         return ret -= rhs;
     }
-    friend bool operator==(const ValueSet& lhs, const ValueSet& rhs) { return lhs.set_ == rhs.set_; }
-    friend bool operator!=(const ValueSet& lhs, const ValueSet& rhs) { return lhs.set_ != rhs.set_; }
+    friend bool operator==(const ValueSet& lhs, const ValueSet& rhs);
+    friend bool operator!=(const ValueSet& lhs, const ValueSet& rhs) { return !(lhs == rhs); }
 
  protected:
     static constexpr unsigned kBitsPerWord = 8 * sizeof(unsigned long);
     static constexpr unsigned kBit2WordShift = detail::lsb(kBitsPerWord);
+    static constexpr unsigned kInlineWordCount = 1;
     static unsigned nword(unsigned v) { return v >> kBit2WordShift; }
     static unsigned nbit(unsigned v) { return v & (kBitsPerWord - 1); }
     static unsigned long bitmask(unsigned v) { return 1ul << nbit(v); }
 
-    // Bit array for presence indication
-    std::array<unsigned long, (kMaxValue + 1) / kBitsPerWord> set_;
+    unsigned long* data() { return capacity_ > kInlineWordCount ? heap_ : &inline_; }
+    const unsigned long* data() const { return capacity_ > kInlineWordCount ? heap_ : &inline_; }
+    void grow(unsigned size);
+
+    // Bit array for presence indication: words after `size_` are treated as zero
+    unsigned size_ = 0;
+    unsigned capacity_ = kInlineWordCount;
+    union {
+        unsigned long inline_ = 0;
+        unsigned long* heap_;
+    };
 };